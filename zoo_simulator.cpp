@@ -15,6 +15,47 @@
 #include <limits>
 #include <numeric>
 #include <random>
+#include <memory_resource>
+#include <map>
+#include <unordered_map>
+#include <string_view>
+#include <new>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <exception>
+#include <type_traits>
+#include <cmath>
+#include <chrono>
+#include <fstream>
+#include <optional>
+#include <charconv>
+#include <coroutine>
+#include <streambuf>
+#include <utility>
+#include <cstring>
+#include <bit>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define ZOO_TARGET_AVX2
+#else
+#define ZOO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
 /**
@@ -56,6 +97,152 @@ enum class WorkerType {
     FEEDER       /**< Кормилец */
 };
 
+/**
+ * @enum CapPolicy
+ * @brief Определяет поведение зоопарка при исчерпании бюджета памяти.
+ */
+enum class CapPolicy {
+    REFUSE,      /**< Отказывать в рождениях и покупках */
+    COHORT       /**< Переводить самых старых животных в когорты */
+};
+
+/**
+ * @class Rng
+ * @brief Генератор псевдослучайных чисел xoshiro256**.
+ *
+ * У каждого зоопарка свой генератор с явным зерном, поэтому партии воспроизводимы и независимы
+ * друг от друга. Удовлетворяет требованиям UniformRandomBitGenerator и может использоваться
+ * со стандартными распределениями.
+ */
+class Rng {
+private:
+    uint64_t state[4]; /**< Состояние генератора */
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    /**
+     * @brief Шаг генератора splitmix64, используемого для инициализации состояния.
+     * @param x Состояние splitmix64.
+     * @return Следующее значение.
+     */
+    static uint64_t splitmix64(uint64_t& x) {
+        uint64_t z = (x += mixIncrement);
+        z = (z ^ (z >> 30)) * mixMultiplier1;
+        z = (z ^ (z >> 27)) * mixMultiplier2;
+        return z ^ (z >> 31);
+    }
+
+public:
+    using result_type = uint64_t; /**< Тип генерируемых значений */
+
+    static constexpr uint64_t mixIncrement = 0x9E3779B97F4A7C15ull;   /**< Приращение splitmix64 */
+    static constexpr uint64_t mixMultiplier1 = 0xBF58476D1CE4E5B9ull; /**< Первый множитель splitmix64 */
+    static constexpr uint64_t mixMultiplier2 = 0x94D049BB133111EBull; /**< Второй множитель splitmix64 */
+
+    /**
+     * @brief Создает генератор.
+     * @param seed Зерно.
+     */
+    explicit Rng(uint64_t seed = 0) { reseed(seed); }
+
+    /**
+     * @brief Переинициализирует генератор.
+     * @param seed Зерно.
+     */
+    void reseed(uint64_t seed) {
+        for (auto& word : state) word = splitmix64(seed);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return numeric_limits<result_type>::max(); }
+
+    /**
+     * @brief Генерирует следующее 64-битное значение.
+     * @return Случайное значение.
+     */
+    result_type operator()() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    /**
+     * @brief Генерирует случайное целое число в диапазоне.
+     * @param min Минимальное значение (включительно).
+     * @param max Максимальное значение (включительно).
+     * @return Случайное целое число.
+     */
+    int uniform(int min, int max) {
+        uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min + 1);
+        // Умножение со сдвигом (Lemire): смещение не превышает range / 2^32 и для игровых диапазонов несущественно.
+        return min + static_cast<int>(((operator()() >> 32) * range) >> 32);
+    }
+
+    /**
+     * @brief Вычисляет значение, однозначно определяемое ключом, без состояния генератора.
+     * @param seed Зерно.
+     * @param day Игровой день.
+     * @param id Идентификатор объекта (например, животного).
+     * @param stream Номер потока событий.
+     * @return Псевдослучайное 64-битное значение.
+     */
+    static uint64_t keyed(uint64_t seed, uint64_t day, uint64_t id, uint64_t stream) {
+        return keyedById(keyedPrefix(seed, day, stream), id);
+    }
+
+    /**
+     * @brief Вычисляет общую для всех объектов часть ключевого значения.
+     *
+     * Для пакетной обработки: префикс считается один раз на день и поток, а на каждый объект
+     * остается один шаг splitmix64 (см. keyedById).
+     * @param seed Зерно.
+     * @param day Игровой день.
+     * @param stream Номер потока событий.
+     * @return Префикс ключа.
+     */
+    static uint64_t keyedPrefix(uint64_t seed, uint64_t day, uint64_t stream) {
+        uint64_t x = seed ^ (stream << 56);
+        uint64_t h = splitmix64(x) ^ day;
+        return splitmix64(h);
+    }
+
+    /**
+     * @brief Завершает вычисление ключевого значения для объекта.
+     * @param prefix Префикс ключа (см. keyedPrefix).
+     * @param id Идентификатор объекта.
+     * @return То же значение, что и keyed с теми же параметрами.
+     */
+    static uint64_t keyedById(uint64_t prefix, uint64_t id) {
+        uint64_t h = prefix ^ id;
+        return splitmix64(h);
+    }
+
+    /**
+     * @brief Переводит 64-битное значение в бросок от 0 до 99.
+     * @param value Псевдослучайное значение.
+     * @return Число от 0 до 99.
+     */
+    static int percent(uint64_t value) { return static_cast<int>(((value >> 32) * 100) >> 32); }
+
+    /**
+     * @brief Вычисляет бросок от 0 до 99, однозначно определяемый ключом.
+     * @param seed Зерно.
+     * @param day Игровой день.
+     * @param id Идентификатор объекта.
+     * @param stream Номер потока событий.
+     * @return Число от 0 до 99.
+     */
+    static int keyedPercent(uint64_t seed, uint64_t day, uint64_t id, uint64_t stream) {
+        return percent(keyed(seed, day, id, stream));
+    }
+};
+
 /**
  * @class Loan
  * @brief Представляет финансовый кредит, взятый зоопарком.
@@ -91,35 +278,107 @@ public:
     double getRemainingDebt() const { return dailyRepayment * daysLeft; }
 };
 
+/**
+ * @class SpeciesRegistry
+ * @brief Справочник названий видов.
+ *
+ * Каждому названию вида (включая гибриды, появившиеся при размножении) присваивается компактный
+ * идентификатор, который хранится в записи животного вместо строки. Виды никогда не удаляются,
+ * поэтому справочник размещается в монотонном ресурсе зоопарка.
+ */
+class SpeciesRegistry {
+private:
+    pmr::map<pmr::string, uint16_t, less<>> ids; /**< Название вида → идентификатор */
+    pmr::vector<const pmr::string*> names;       /**< Идентификатор → название (узлы map не перемещаются) */
+
+public:
+    /**
+     * @brief Создает справочник.
+     * @param resource Ресурс памяти справочника.
+     */
+    explicit SpeciesRegistry(pmr::memory_resource* resource = pmr::get_default_resource())
+        : ids(resource), names(resource) {
+    }
+
+    /**
+     * @brief Получает идентификатор вида, регистрируя его при первом обращении.
+     * @param name Название вида.
+     * @return Идентификатор вида.
+     * @throws runtime_error Если количество видов превысило допустимое.
+     */
+    uint16_t intern(string_view name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        if (names.size() > numeric_limits<uint16_t>::max()) throw runtime_error("Превышено количество видов.");
+        uint16_t id = static_cast<uint16_t>(names.size());
+        it = ids.emplace(pmr::string(name, ids.get_allocator().resource()), id).first;
+        names.push_back(&it->first);
+        return id;
+    }
+
+    /**
+     * @brief Получает название вида.
+     * @param id Идентификатор вида.
+     * @return Название вида.
+     */
+    const pmr::string& getName(uint16_t id) const { return *names[id]; }
+
+    /**
+     * @brief Находит вид по названию, не регистрируя его.
+     * @param name Название вида.
+     * @return Идентификатор вида или пустое значение, если вид не зарегистрирован.
+     */
+    optional<uint16_t> find(string_view name) const {
+        auto it = ids.find(name);
+        if (it == ids.end()) return nullopt;
+        return it->second;
+    }
+
+    /**
+     * @brief Получает количество зарегистрированных видов.
+     * @return Количество видов.
+     */
+    size_t size() const { return names.size(); }
+};
+
 /**
  * @class Animal
  * @brief Представляет животное в зоопарке.
  *
- * Хранит информацию о животном, включая вид, возраст, вес и состояние здоровья.
- * Поддерживает размножение через оператор +.
+ * Компактная запись (24 байта): вид хранится идентификатором, перечисления и флаги — битовыми полями,
+ * вес — числом одинарной точности. Отображаемое имя, отличающееся от названия вида, хранится в отдельной
+ * таблице зоопарка (см. NameArena), родители — в родословной (см. Pedigree), поэтому запись копируется
+ * без выделения памяти. Идентификатор выдает зоопарк, в котором животное появилось, поэтому несколько
+ * зоопарков в разных потоках нумеруют животных независимо и воспроизводимо.
  */
 class Animal {
 private:
-    string species;             /**< Вид животного (например, "Лев") */
-    string displayName;         /**< Отображаемое имя животного */
-    int ageDays;               /**< Возраст животного в днях */
-    double weight;             /**< Вес животного в килограммах */
-    Climate preferredClimate;   /**< Предпочитаемый климат животного */
-    int price;                 /**< Стоимость покупки животного */
-    AnimalType type;           /**< Тип животного (травоядное или хищник) */
-    int enclosureId;           /**< Идентификатор вольера, в котором содержится животное */
-    int daysSincePurchase;     /**< Дни с момента покупки животного */
-    Gender gender;             /**< Пол животного */
-    bool isBornInZoo;          /**< Истина, если животное родилось в зоопарке */
-    pair<string, string> parents; /**< Имена родителей животного */
-    bool isSick;               /**< Истина, если животное болеет */int uniqueId;              /**< Уникальный идентификатор животного */
-    static int nextId;          /**< Статический счетчик для генерации уникальных идентификаторов */
+    uint32_t uniqueId;         /**< Уникальный идентификатор животного */
+    float weight;              /**< Вес животного в килограммах */
+    int32_t price;             /**< Стоимость покупки животного */
+    uint16_t speciesId;        /**< Идентификатор вида в SpeciesRegistry */
+    int16_t enclosureId;       /**< Идентификатор вольера, в котором содержится животное */
+    uint16_t ageDays;          /**< Возраст животного в днях */
+    uint16_t daysSincePurchase;/**< Дни с момента покупки животного */
+    uint8_t type : 1;          /**< Тип животного (AnimalType) */
+    uint8_t preferredClimate : 2; /**< Предпочитаемый климат животного (Climate) */
+    uint8_t gender : 1;        /**< Пол животного (Gender) */
+    uint8_t isBornInZoo : 1;   /**< Истина, если животное родилось в зоопарке */
+    uint8_t isSick : 1;        /**< Истина, если животное болеет */
+    uint8_t hasCustomName : 1; /**< Истина, если имя хранится в таблице имен */
+
+    /**
+     * @brief Увеличивает 16-битный счетчик дней без переполнения.
+     * @param value Счетчик.
+     */
+    static void saturatingIncrement(uint16_t& value) {
+        if (value < numeric_limits<uint16_t>::max()) value++;
+    }
 
 public:
     /**
      * @brief Создает объект животного.
-     * @param sp Название вида.
-     * @param name Отображаемое имя.
+     * @param sp Идентификатор вида.
      * @param age Возраст в днях.
      * @param w Вес в килограммах.
      * @param c Предпочитаемый климат.
@@ -129,27 +388,22 @@ public:
      * @param born Истина, если родилось в зоопарке (по умолчанию false).
      * @param encId Идентификатор вольера (по умолчанию -1).
      * @param daysPurch Дни с момента покупки (по умолчанию 0).
-     * @param par Имена родителей (по умолчанию {"None", "None"}).
      * @param sick Истина, если животное болеет (по умолчанию false).
      */
-    Animal(string sp, string name, int age, double w, Climate c, int p, AnimalType t, Gender g, bool born = false,
-        int encId = -1, int daysPurch = 0, pair<string, string> par = { "None", "None" }, bool sick = false)
-        : species(sp), displayName(name), ageDays(age), weight(w), preferredClimate(c), price(p), type(t),
-        enclosureId(encId), daysSincePurchase(daysPurch), gender(g), isBornInZoo(born), parents(par),
-        isSick(sick), uniqueId(nextId++) {
+    Animal(uint16_t sp, int age, double w, Climate c, int p, AnimalType t, Gender g, bool born = false,
+        int encId = -1, int daysPurch = 0, bool sick = false)
+        : uniqueId(0), weight(static_cast<float>(w)), price(p), speciesId(sp),
+        enclosureId(static_cast<int16_t>(encId)), ageDays(static_cast<uint16_t>(age)),
+        daysSincePurchase(static_cast<uint16_t>(daysPurch)), type(static_cast<uint8_t>(t)),
+        preferredClimate(static_cast<uint8_t>(c)), gender(static_cast<uint8_t>(g)), isBornInZoo(born), isSick(sick),
+        hasCustomName(false) {
     }
 
     /**
-     * @brief Получает название вида.
-     * @return Название вида.
-     */
-    string getSpecies() const { return species; }
-
-    /**
-     * @brief Получает отображаемое имя.
-     * @return Отображаемое имя.
+     * @brief Получает идентификатор вида.
+     * @return Идентификатор вида в SpeciesRegistry.
      */
-    string getDisplayName() const { return displayName; }
+    uint16_t getSpeciesId() const { return speciesId; }
 
     /**
      * @brief Получает возраст в днях.
@@ -167,7 +421,7 @@ public:
      * @brief Получает предпочитаемый климат.
      * @return Предпочитаемый климат.
      */
-    Climate getPreferredClimate() const { return preferredClimate; }
+    Climate getPreferredClimate() const { return static_cast<Climate>(preferredClimate); }
 
     /**
      * @brief Получает стоимость покупки.
@@ -179,7 +433,7 @@ public:
      * @brief Получает тип животного.
      * @return Тип животного (травоядное или хищник).
      */
-    AnimalType getType() const { return type; }
+    AnimalType getType() const { return static_cast<AnimalType>(type); }
 
     /**
      * @brief Получает идентификатор вольера.
@@ -197,7 +451,7 @@ public:
      * @brief Получает пол животного.
      * @return Пол животного.
      */
-    Gender getGender() const { return gender; }
+    Gender getGender() const { return static_cast<Gender>(gender); }
 
     /**
      * @brief Проверяет, родилось ли животное в зоопарке.
@@ -205,45 +459,63 @@ public:
      */
     bool getIsBornInZoo() const { return isBornInZoo; }
 
-    /**
-     * @brief Получает имена родителей.
-     * @return Пара имен родителей.
-     */
-    pair<string, string> getParents() const { return parents; }
-
     /**
      * @brief Проверяет, болеет ли животное.
      * @return Истина, если животное болеет.
      */
     bool getIsSick() const { return isSick; }
 
+    /**
+     * @brief Проверяет, достаточно ли животное взрослое для размножения.
+     * @return Истина, если животному больше 5 дней.
+     */
+    bool canBreed() const { return ageDays > 5; }
+
+    /**
+     * @brief Проверяет, задано ли животному собственное имя.
+     * @return Истина, если имя хранится в таблице имен, иначе именем служит название вида.
+     */
+    bool getHasCustomName() const { return hasCustomName; }
+
     /**
      * @brief Получает уникальный идентификатор.
      * @return Уникальный идентификатор.
      */
-    int getUniqueId() const { return uniqueId; }
+    int getUniqueId() const { return static_cast<int>(uniqueId); }
+
+    /**
+     * @brief Устанавливает уникальный идентификатор.
+     * @param id Идентификатор, выданный зоопарком.
+     */
+    void setUniqueId(uint32_t id) { uniqueId = id; }
 
     /**
      * @brief Устанавливает идентификатор вольера.
      * @param id Новый идентификатор вольера.
      */
-    void setEnclosureId(int id) { enclosureId = id; }
+    void setEnclosureId(int id) { enclosureId = static_cast<int16_t>(id); }
+
+    /**
+     * @brief Устанавливает идентификатор вида.
+     * @param sp Идентификатор вида в справочнике владельца записи.
+     */
+    void setSpeciesId(uint16_t sp) { speciesId = sp; }
 
     /**
      * @brief Увеличивает дни с момента покупки.
      */
-    void incrementDaysSincePurchase() { daysSincePurchase++; }
+    void incrementDaysSincePurchase() { saturatingIncrement(daysSincePurchase); }
 
     /**
      * @brief Увеличивает возраст в днях.
      */
-    void incrementAgeDays() { ageDays++; }
+    void incrementAgeDays() { saturatingIncrement(ageDays); }
 
     /**
-     * @brief Устанавливает отображаемое имя.
-     * @param name Новое отображаемое имя.
+     * @brief Отмечает, что имя животного хранится в таблице имен.
+     * @param custom Истина, если имя задано в таблице имен.
      */
-    void setDisplayName(const string& name) { displayName = name; }
+    void setHasCustomName(bool custom) { hasCustomName = custom; }
 
     /**
      * @brief Устанавливает статус болезни.* @param sick Истина, чтобы отметить животное как больное.
@@ -253,1189 +525,7474 @@ public:
     /**
      * @brief Размножает двух животных для создания новорожденного.
      * @param other Другое животное для размножения.
-     * @return Новый объект Animal, представляющий новорожденного.
+     * @param registry Справочник видов (название гибрида регистрируется в нем).
+     * @param newGender Пол новорожденного.
+     * @return Новый объект Animal, представляющий новорожденного (родителей регистрирует вызывающий в Pedigree).
      * @throws runtime_error Если животные не в одном вольере, одного пола или слишком молоды (<= 5 дней).
      */
-    Animal operator+(const Animal& other) const {
-        if (enclosureId != other.enclosureId || gender == other.gender || ageDays <= 5 || other.ageDays <= 5) {
+    Animal breed(const Animal& other, SpeciesRegistry& registry, Gender newGender) const {
+        if (enclosureId != other.enclosureId || gender == other.gender || !canBreed() || !other.canBreed()) {
             throw runtime_error("Невозможно размножить: должны быть разных видов, противоположного пола, старше 5 дней и в одном вольере.");
         }
-        string newSpecies = species.substr(0, species.length() / 2) + other.species.substr(other.species.length() / 2);
-        string newName = newSpecies + "_Новорождённый";
-        Gender newGender = (rand() % 2 == 0) ? Gender::MALE : Gender::FEMALE;
+        // Название гибрида — первая половина названия одного родителя и вторая половина другого;
+        // для родителей одного вида оно совпадает с исходным.
+        uint16_t newSpecies = speciesId;
+        if (other.speciesId != speciesId) {
+            const pmr::string& head = registry.getName(speciesId);
+            const pmr::string& tail = registry.getName(other.speciesId);
+            char buffer[256];
+            size_t headLen = head.copy(buffer, min(head.length() / 2, sizeof(buffer)), 0);
+            size_t tailLen = tail.copy(buffer + headLen, sizeof(buffer) - headLen, tail.length() / 2);
+            newSpecies = registry.intern(string_view(buffer, headLen + tailLen));
+        }
         double newWeight = (weight + other.weight) / 4;
         int newPrice = (price + other.price) / 2;
-        return Animal(newSpecies, newName, 0, newWeight, preferredClimate, newPrice, type, newGender, true, enclosureId, 0, { displayName, other.displayName });
+        return Animal(newSpecies, 0, newWeight, getPreferredClimate(), newPrice, getType(), newGender, true, enclosureId);
     }
 };
 
-/** @brief Статический счетчик для генерации уникальных идентификаторов животных. */
-int Animal::nextId = 1;
+static_assert(sizeof(Animal) == 24, "Запись животного должна занимать 24 байта");
 
 /**
- * @class Enclosure
- * @brief Представляет вольер в зоопарке.
+ * @class NameArena
+ * @brief Хранилище отображаемых имен животных.
  *
- * Управляет коллекцией животных с определенной вместимостью, типом животных и климатом.
+ * Хранит только имена, отличающиеся от названия вида: переименованные и рожденные в зоопарке животные.
+ * Короткие имена (до inlineCapacity байт) лежат прямо в слоте, длинные — в общем буфере символов.
+ * Переименование перезаписывает имя на месте, если оно помещается в уже занятый участок,
+ * поэтому повторные переименования не выделяют память. Освобожденные участки буфера учитываются
+ * и собираются уплотнением, когда мусор превышает половину буфера.
  */
-class Enclosure {
+class NameArena {
 private:
-    int id;                    /**< Уникальный идентификатор вольера */
-    int capacity;              /**< Максимальное количество животных в вольере */
-    AnimalType animalType;     /**< Тип животных, разрешенных в вольере */
-    Climate climate;           /**< Климат вольера */
-    int dailyCost;             /**< Ежедневная стоимость содержания */
-    vector<Animal> animals;    /**< Список животных в вольере */
+    static constexpr uint32_t inlineCapacity = 24; /**< Вместимость встроенного хранения, байт */
+
+    struct Slot {
+        uint32_t length;       /**< Длина имени в байтах */
+        uint32_t capacity;     /**< Вместимость участка (inlineCapacity для встроенного имени) */
+        union {
+            char inlineChars[inlineCapacity]; /**< Встроенное имя */
+            uint32_t offset;                  /**< Смещение участка в буфере */
+        };
+
+        bool isInline() const { return capacity == inlineCapacity; }
+    };
+
+    pmr::unordered_map<uint32_t, Slot> slots; /**< Идентификатор животного → слот имени */
+    pmr::vector<char> storage;                /**< Буфер длинных имен */
+    size_t garbage;                           /**< Байты буфера, не занятые живыми именами */
 
-public:
     /**
-     * @brief Создает объект вольера.
-     * @param i Идентификатор вольера.
-     * @param cap Максимальная вместимость.
-     * @param t Тип разрешенных животных.
-     * @param c Климат вольера.
-     * @param cost Ежедневная стоимость содержания.
+     * @brief Уплотняет буфер длинных имен.
      */
-    Enclosure(int i, int cap, AnimalType t, Climate c, int cost)
-        : id(i), capacity(cap), animalType(t), climate(c), dailyCost(cost) {
+    void compact() {
+        pmr::vector<char> packed(storage.get_allocator());
+        packed.reserve(storage.size() - garbage);
+        for (auto& entry : slots) {
+            Slot& slot = entry.second;
+            if (slot.isInline()) continue;
+            uint32_t newOffset = static_cast<uint32_t>(packed.size());
+            packed.insert(packed.end(), storage.begin() + slot.offset, storage.begin() + slot.offset + slot.capacity);
+            slot.offset = newOffset;
+        }
+        storage.swap(packed);
+        garbage = 0;
     }
 
     /**
-     * @brief Получает идентификатор вольера.
-     * @return Идентификатор вольера.
+     * @brief Освобождает участок буфера, занятый слотом.
+     * @param slot Слот с длинным именем.
      */
-    int getId() const { return id; }
+    void release(const Slot& slot) {
+        if (slot.isInline()) return;
+        garbage += slot.capacity;
+        if (garbage > storage.size() / 2 && storage.size() > 4096) compact();
+    }
 
+public:
     /**
-     * @brief Получает вместимость.
-     * @return Максимальное количество животных.
+     * @brief Создает хранилище имен.
+     * @param resource Ресурс памяти хранилища.
      */
-    int getCapacity() const { return capacity; }
+    explicit NameArena(pmr::memory_resource* resource = pmr::get_default_resource())
+        : slots(resource), storage(resource), garbage(0) {
+    }
 
     /**
-     * @brief Получает тип животных.
-     * @return Тип разрешенных животных.
+     * @brief Устанавливает имя животного.
+     * @param id Идентификатор животного.
+     * @param name Новое имя.
      */
-    AnimalType getAnimalType() const { return animalType; }
+    void set(uint32_t id, string_view name) {
+        auto it = slots.find(id);
+        if (it == slots.end()) {
+            Slot empty{};
+            empty.capacity = inlineCapacity;
+            it = slots.emplace(id, empty).first;
+        }
+        Slot& slot = it->second;
+        uint32_t length = static_cast<uint32_t>(name.size());
+        if (slot.isInline() && length <= inlineCapacity) {
+            name.copy(slot.inlineChars, length);
+        }
+        else if (!slot.isInline() && length <= slot.capacity) {
+            name.copy(storage.data() + slot.offset, length);
+        }
+        else if (length <= inlineCapacity) {
+            Slot old = slot;
+            slot.capacity = inlineCapacity;
+            name.copy(slot.inlineChars, length);
+            release(old);
+        }
+        else {
+            Slot old = slot;
+            uint32_t capacity = (length + 15) & ~15u; // запас под следующие переименования (всегда больше inlineCapacity)
+            uint32_t offset = static_cast<uint32_t>(storage.size());
+            storage.resize(storage.size() + capacity); // слот меняется только после успешного выделения
+            slot.offset = offset;
+            slot.capacity = capacity;
+            name.copy(storage.data() + slot.offset, length);
+            release(old); // после перевода слота на новый участок: уплотнение не копирует старый
+        }
+        slot.length = length;
+    }
 
     /**
-     * @brief Получает климат.
-     * @return Климат вольера.
+     * @brief Получает имя животного.
+     * @param id Идентификатор животного.
+     * @return Имя или пустая строка, если имя не задано. Действительно до следующего изменения хранилища.
      */
-    Climate getClimate() const { return climate; }
+    string_view get(uint32_t id) const {
+        auto it = slots.find(id);
+        if (it == slots.end()) return string_view();
+        const Slot& slot = it->second;
+        return slot.isInline() ? string_view(slot.inlineChars, slot.length) : string_view(storage.data() + slot.offset, slot.length);
+    }
 
     /**
-     * @brief Получает ежедневную стоимость.
-     * @return Ежедневная стоимость содержания.
+     * @brief Удаляет имя животного.
+     * @param id Идентификатор животного.
      */
-    int getDailyCost() const { return dailyCost; }
+    void erase(uint32_t id) {
+        auto it = slots.find(id);
+        if (it == slots.end()) return;
+        Slot slot = it->second;
+        slots.erase(it);
+        release(slot);
+    }
+};
 
-    /**
-     * @brief Получает количество животных.
-     * @return Количество животных в вольере.
-     */
-    size_t getAnimalCount() const { return animals.size(); }
+/**
+ * @class Pedigree
+ * @brief Родословная животных зоопарка.
+ *
+ * Граф «животное → родители» по идентификаторам. Узлы не удаляются при смерти или продаже животного,
+ * поэтому линии происхождения сохраняются на любом числе поколений. Узлы добавляются в порядке
+ * поступления животных, и родители всегда имеют меньший индекс, чем потомки; на этом основаны
+ * отсечение при поиске предков и табличный расчет коэффициента родства.
+ *
+ * Коэффициент инбридинга Райта потомка равен коэффициенту родства (coancestry) его родителей:
+ * f(a, a) = (1 + F(a)) / 2; f(a, b) = (f(отец a, b) + f(мать a, b)) / 2, где a — более поздний узел.
+ * Вычисленные коэффициенты родства кэшируются между днями, поэтому рождение в глубокой линии проходит
+ * только по парам, которых еще нет в кэше. Кэш ограничен kinshipCacheLimit парами и состоит из двух
+ * поколений: когда текущее заполняется наполовину, оно становится прежним, а старое прежнее отбрасывается;
+ * найденные в прежнем поколении пары переносятся в текущее, поэтому часто нужные пары не теряются.
+ */
+class Pedigree {
+private:
+    static constexpr uint32_t none = numeric_limits<uint32_t>::max(); /**< Отсутствующий родитель */
+    static constexpr size_t kinshipCacheLimit = 1 << 16;              /**< Наибольшее число пар в кэше родства */
 
-    /**
-     * @brief Получает список животных.
-     * @return Ссылка на вектор животных.
-     */
-    const vector<Animal>& getAnimals() const { return animals; }
+    struct Node {
+        uint32_t animalId;     /**< Идентификатор животного */
+        uint32_t parents[2];   /**< Индексы узлов родителей (none, если неизвестны) */
+        uint16_t speciesId;    /**< Идентификатор вида */
+        bool present;          /**< Истина, пока животное в зоопарке */
+        float inbreeding;      /**< Коэффициент инбридинга Райта */
+    };
+
+    pmr::vector<Node> nodes;                           /**< Узлы в порядке поступления */
+    pmr::unordered_map<uint32_t, uint32_t> indexById;  /**< Идентификатор животного → индекс узла */
+    mutable pmr::unordered_map<uint64_t, float> kinshipCache;    /**< Кэш коэффициентов родства (текущее поколение) */
+    mutable pmr::unordered_map<uint64_t, float> kinshipPrevious; /**< Прежнее поколение кэша родства */
+    mutable pmr::vector<uint32_t> visitMark;           /**< Отметки обхода для поиска предков */
+    mutable uint32_t visitEpoch;                       /**< Текущая метка обхода */
 
     /**
-     * @brief Проверяет, можно ли добавить животное в вольер.
-     * @param animal Животное для проверки.
-     * @return Истина, если животное можно добавить (соответствует типу, климату и вместимость не превышена).
+     * @brief Получает индекс узла животного.
+     * @param animalId Идентификатор животного.
+     * @return Индекс узла или none.
      */
-    bool canAddAnimal(const Animal& animal) const {
-        return animals.size() < static_cast<size_t>(capacity) &&
-            animal.getType() == animalType &&
-            animal.getPreferredClimate() == climate;
+    uint32_t indexOf(uint32_t animalId) const {
+        auto it = indexById.find(animalId);
+        return it != indexById.end() ? it->second : none;
     }
 
     /**
-     * @brief Добавляет животное в вольер.
-     * @param animal Животное для добавления.
+     * @brief Получает коэффициент родства без вычислений: для простых случаев или из кэша.
+     * @param a Индекс первого узла.
+     * @param b Индекс второго узла.
+     * @param value Коэффициент (заполняется, если известен).
+     * @return Истина, если коэффициент известен.
      */
-    void addAnimal(const Animal& animal) {
-        animals.push_back(animal);
+    bool knownKinship(uint32_t a, uint32_t b, float& value) const {
+        if (a == none || b == none) {
+            value = 0.0f;
+            return true;
+        }
+        if (a < b) swap(a, b);
+        const Node& younger = nodes[a];
+        if (a == b) value = 0.5f * (1.0f + younger.inbreeding);
+        else if (younger.parents[0] == none && younger.parents[1] == none) value = 0.0f;
+        else {
+            uint64_t key = (static_cast<uint64_t>(a) << 32) | b;
+            auto it = kinshipCache.find(key);
+            if (it != kinshipCache.end()) value = it->second;
+            else {
+                auto old = kinshipPrevious.find(key);
+                if (old == kinshipPrevious.end()) return false;
+                value = old->second;
+                kinshipCache.emplace(key, value);
+            }
+        }
+        return true;
     }
 
     /**
-     * @brief Удаляет животное из вольера.
-     * @param uniqueId Уникальный идентификатор животного для удаления.
+     * @brief Вычисляет коэффициент родства двух узлов.
+     *
+     * Пары вычисляются от более поздних узлов к ранним через явный стек: пара ждет в стеке, пока не
+     * известны коэффициенты обоих родителей ее более позднего узла со вторым узлом. Глубина родословной
+     * ограничивает только размер стека, а не стек вызовов.
+     * @param a Индекс первого узла.
+     * @param b Индекс второго узла.
+     * @return Коэффициент родства f(a, b).
      */
-    void removeAnimal(int uniqueId) {
-        animals.erase(remove_if(animals.begin(), animals.end(), [uniqueId](const Animal& a) { return a.getUniqueId() == uniqueId; }),
-            animals.end());
+    float kinship(uint32_t a, uint32_t b) const {
+        float value = 0.0f;
+        if (knownKinship(a, b, value)) return value;
+        if (kinshipCache.size() >= kinshipCacheLimit / 2) {
+            // Смена поколений только между вычислениями: пары текущего обхода не должны пропасть до его конца.
+            kinshipPrevious.swap(kinshipCache);
+            kinshipCache.clear();
+        }
+        pmr::vector<pair<uint32_t, uint32_t>> pending(nodes.get_allocator().resource());
+        pending.emplace_back(max(a, b), min(a, b));
+        while (!pending.empty()) {
+            auto [younger, other] = pending.back();
+            const uint32_t* parents = nodes[younger].parents;
+            float halves[2];
+            bool ready = true;
+            for (int k = 0; k < 2; ++k) {
+                if (knownKinship(parents[k], other, halves[k])) continue;
+                pending.emplace_back(max(parents[k], other), min(parents[k], other));
+                ready = false;
+            }
+            if (!ready) continue;
+            kinshipCache.emplace((static_cast<uint64_t>(younger) << 32) | other, 0.5f * (halves[0] + halves[1]));
+            pending.pop_back();
+        }
+        knownKinship(a, b, value);
+        return value;
     }
 
     /**
-     * @brief Обновляет животное в вольере.
-     * @param updatedAnimal Обновленный объект животного.
+     * @brief Добавляет узел.
+     * @param animalId Идентификатор животного.
+     * @param speciesId Идентификатор вида.
+     * @param first Индекс первого родителя.
+     * @param second Индекс второго родителя.
      */
-    void updateAnimal(const Animal& updatedAnimal) {
-        for (auto& animal : animals) {
-            if (animal.getUniqueId() == updatedAnimal.getUniqueId()) {
-                animal = updatedAnimal;
-                return;
-            }
+    void addNode(uint32_t animalId, uint16_t speciesId, uint32_t first, uint32_t second) {
+        if (indexById.count(animalId)) return;
+        float f = kinship(first, second);
+        nodes.push_back({ animalId, { first, second }, speciesId, true, f });
+        try {
+            visitMark.push_back(0);
+            indexById.emplace(animalId, static_cast<uint32_t>(nodes.size() - 1));
+        }
+        catch (...) {
+            if (visitMark.size() == nodes.size()) visitMark.pop_back();
+            nodes.pop_back();
+            throw;
         }
     }
-};
-
-/**
- * @class Worker
- * @brief Представляет работника зоопарка.
- *
- * Управляет информацией о работнике, включая роль, зарплату и назначенные вольеры.
- */
-class Worker {
-private:
-    string name;                   /**< Имя работника */
-    WorkerType type;               /**< Тип работника (директор, ветеринар и т.д.) */
-    int salary;                    /**< Ежедневная зарплата */
-    vector<int> assignedEnclosures;/**< Идентификаторы назначенных вольеров */
-    int daysAssigned;              /**< Количество дней назначения на вольеры */
-    int daysWorked;                /**< Общее количество отработанных дней */
-    int maxAnimals;                /**< Максимальное количество животных для ветеринара (0 для других) */
 
 public:
     /**
-     * @brief Создает объект работника.
-     * @param n Имя работника.
-     * @param t Тип работника.
-     * @param sal Ежедневная зарплата.
-     * @param maxA Максимальное количество животных (для ветеринаров, по умолчанию 0).
-     * @param encs Идентификаторы назначенных вольеров (по умолчанию пусто).
-     * @param daysAss Дни назначения на вольеры (по умолчанию 0).
-     * @param daysW Общее количество отработанных дней (по умолчанию 0).
+     * @brief Создает пустую родословную.
+     * @param resource Ресурс памяти родословной.
      */
-    Worker(string n, WorkerType t, int sal, int maxA = 0, vector<int> encs = {}, int daysAss = 0, int daysW = 0)
-        : name(n), type(t), salary(sal), assignedEnclosures(encs), daysAssigned(daysAss), daysWorked(daysW), maxAnimals(maxA) {
+    explicit Pedigree(pmr::memory_resource* resource = pmr::get_default_resource())
+        : nodes(resource), indexById(resource), kinshipCache(resource), kinshipPrevious(resource), visitMark(resource), visitEpoch(0) {
     }
 
     /**
-     * @brief Получает зарплату для типа работника.
-     * @param t Тип работника.
-     * @return Ежедневная зарплата для типа.
-     */
-    static int getSalaryForType(WorkerType t) {
-        switch (t) {
-        case WorkerType::DIRECTOR: return 60;
-        case WorkerType::VETERINARIAN: return 50;
-        case WorkerType::CLEANER: return 30;
-        case WorkerType::FEEDER: return 40;
-        default: return 0;
+     * @brief Регистрирует животное без известных родителей (купленное).
+     * @param animalId Идентификатор животного.
+     * @param speciesId Идентификатор вида.
+     */
+    void addFounder(uint32_t animalId, uint16_t speciesId) { addNode(animalId, speciesId, none, none); }
+
+    /**
+     * @brief Оценивает объем памяти, который может запросить добавление следующего узла.
+     * @return Размер в байтах (без роста кэша родства).
+     */
+    size_t growthReserve() const {
+        size_t bytes = 4 * sizeof(void*) + sizeof(pair<const uint32_t, uint32_t>);
+        if (nodes.size() == nodes.capacity()) bytes += max<size_t>(1, nodes.capacity() * 2) * sizeof(Node);
+        if (visitMark.size() == visitMark.capacity()) bytes += max<size_t>(1, visitMark.capacity() * 2) * sizeof(uint32_t);
+        if (indexById.size() + 1 > indexById.bucket_count() * indexById.max_load_factor()) {
+            bytes += indexById.bucket_count() * 2 * sizeof(void*);
         }
+        return bytes;
     }
 
     /**
-     * @brief Получает имя работника.
-     * @return Имя работника.
+     * @brief Сбрасывает кэш коэффициентов родства; значения будут вычислены заново по требованию.
+     *
+     * Вызывается при исчерпании бюджета памяти.
      */
-    string getName() const { return name; }
+    void clearKinshipCache() {
+        kinshipCache.clear();
+        kinshipPrevious.clear();
+    }
 
     /**
-     * @brief Получает тип работника.
-     * @return Тип работника.
+     * @brief Регистрирует рожденное животное и вычисляет его коэффициент инбридинга.
+     * @param animalId Идентификатор новорожденного.
+     * @param speciesId Идентификатор вида.
+     * @param firstParentId Идентификатор первого родителя.
+     * @param secondParentId Идентификатор второго родителя.
+     * @return Коэффициент инбридинга новорожденного.
      */
-    WorkerType getType() const { return type; }
+    float addBirth(uint32_t animalId, uint16_t speciesId, uint32_t firstParentId, uint32_t secondParentId) {
+        addNode(animalId, speciesId, indexOf(firstParentId), indexOf(secondParentId));
+        return getInbreeding(animalId);
+    }
 
     /**
-     * @brief Получает ежедневную зарплату.
-     * @return Ежедневная зарплата.
+     * @brief Отмечает, что животное покинуло зоопарк (узел сохраняется).
+     * @param animalId Идентификатор животного.
      */
-    int getSalary() const { return salary; }
+    void markDeparted(uint32_t animalId) {
+        uint32_t index = indexOf(animalId);
+        if (index != none) nodes[index].present = false;
+    }
 
     /**
-     * @brief Получает идентификаторы назначенных вольеров.
-     * @return Ссылка на вектор идентификаторов вольеров.
+     * @brief Отмечает, что животное снова в зоопарке (при отмене его ухода).
+     * @param animalId Идентификатор животного.
      */
-    const vector<int>& getAssignedEnclosures() const { return assignedEnclosures; }
+    void markPresent(uint32_t animalId) {
+        uint32_t index = indexOf(animalId);
+        if (index != none) nodes[index].present = true;
+    }
 
     /**
-     * @brief Получает количество дней назначения.
-     * @return Дни назначения.
+     * @brief Проверяет, известно ли животное родословной.
+     * @param animalId Идентификатор животного.
+     * @return Истина, если узел существует.
      */
-    int getDaysAssigned() const { return daysAssigned; }
+    bool contains(uint32_t animalId) const { return indexOf(animalId) != none; }
 
     /**
-     * @brief Получает общее количество отработанных дней.
-     * @return Отработанные дни.
+     * @brief Проверяет, находится ли животное в зоопарке.
+     * @param animalId Идентификатор животного.
+     * @return Истина, если животное зарегистрировано и не покинуло зоопарк.
      */
-    int getDaysWorked() const { return daysWorked; }
+    bool isPresent(uint32_t animalId) const {
+        uint32_t index = indexOf(animalId);
+        return index != none && nodes[index].present;
+    }
 
     /**
-     * @brief Получает максимальное количество животных (для ветеринаров).
-     * @return Максимальное количество животных.
+     * @brief Получает вид животного, в том числе покинувшего зоопарк.
+     * @param animalId Идентификатор животного (должен быть зарегистрирован).
+     * @return Идентификатор вида.
      */
-    int getMaxAnimals() const { return maxAnimals; }
+    uint16_t getSpeciesId(uint32_t animalId) const { return nodes[indexOf(animalId)].speciesId; }
 
     /**
-     * @brief Получает строковое представление типа работника.
-     * @return Тип работника в виде строки (например, "Директор").
+     * @brief Получает идентификаторы родителей.
+     * @param animalId Идентификатор животного.
+     * @return Пара идентификаторов родителей (0, если неизвестны).
      */
-    string getTypeString() const {
-        switch (type) {
-        case WorkerType::DIRECTOR: return "Директор";
-        case WorkerType::VETERINARIAN: return "Ветеринар";case WorkerType::CLEANER: return "Уборщик";
-        case WorkerType::FEEDER: return "Кормилец";
-        default: return "Неизвестно";
-        }
+    pair<uint32_t, uint32_t> getParentIds(uint32_t animalId) const {
+        uint32_t index = indexOf(animalId);
+        if (index == none) return { 0, 0 };
+        const Node& node = nodes[index];
+        return { node.parents[0] != none ? nodes[node.parents[0]].animalId : 0,
+                 node.parents[1] != none ? nodes[node.parents[1]].animalId : 0 };
     }
 
     /**
-     * @brief Назначает вольер работнику.
-     * @param encId Идентификатор вольера для назначения.
+     * @brief Получает коэффициент инбридинга Райта.
+     * @param animalId Идентификатор животного.
+     * @return Коэффициент инбридинга (0 для неизвестных и основателей).
      */
-    void assignEnclosure(int encId) {
-        if (find(assignedEnclosures.begin(), assignedEnclosures.end(), encId) == assignedEnclosures.end()) {
-            assignedEnclosures.push_back(encId);
-        }
+    float getInbreeding(uint32_t animalId) const {
+        uint32_t index = indexOf(animalId);
+        return index != none ? nodes[index].inbreeding : 0.0f;
     }
 
     /**
-     * @brief Очищает все назначенные вольеры.
+     * @brief Вычисляет коэффициент инбридинга возможного потомка двух животных.
+     * @param firstId Идентификатор первого животного.
+     * @param secondId Идентификатор второго животного.
+     * @return Коэффициент родства пары.
      */
-    void clearAssignedEnclosures() { assignedEnclosures.clear(); }
+    float getKinship(uint32_t firstId, uint32_t secondId) const { return kinship(indexOf(firstId), indexOf(secondId)); }
 
     /**
-     * @brief Устанавливает количество дней назначения.
-     * @param days Количество дней.
+     * @brief Проверяет, является ли одно животное предком другого.
+     * @param ancestorId Идентификатор возможного предка.
+     * @param descendantId Идентификатор потомка.
+     * @return Истина, если ancestorId встречается среди предков descendantId.
      */
-    void setDaysAssigned(int days) { daysAssigned = days; }
+    bool isAncestor(uint32_t ancestorId, uint32_t descendantId) const {
+        uint32_t target = indexOf(ancestorId);
+        uint32_t start = indexOf(descendantId);
+        if (target == none || start == none || target >= start) return false;
+        bool found = false;
+        forEachAncestorIndex(start, [&](uint32_t index) {
+            if (index == target) found = true;
+            return !found && index > target; // у узлов с меньшим индексом, чем цель, цели среди предков нет
+        });
+        return found;
+    }
 
     /**
-     * @brief Уменьшает дни назначения (если положительны).
+     * @brief Обходит всех предков животного (каждого один раз).
+     * @param animalId Идентификатор животного.
+     * @param visit Функция, вызываемая с идентификатором предка.
      */
-    void decrementDaysAssigned() { if (daysAssigned > 0) daysAssigned--; }
+    template <class Visitor>
+    void forEachAncestor(uint32_t animalId, Visitor visit) const {
+        uint32_t start = indexOf(animalId);
+        if (start == none) return;
+        forEachAncestorIndex(start, [&](uint32_t index) { visit(nodes[index].animalId); return true; });
+    }
 
+private:
     /**
-     * @brief Увеличивает общее количество отработанных дней.
+     * @brief Обходит предков узла в глубину без повторов.
+     * @param start Индекс начального узла.
+     * @param visit Функция от индекса предка; возвращает ложь, чтобы не обходить его предков.
      */
-    void incrementDaysWorked() { daysWorked++; }
-};
-
+    template <class Visitor>
+    void forEachAncestorIndex(uint32_t start, Visitor visit) const {
+        if (++visitEpoch == 0) {
+            fill(visitMark.begin(), visitMark.end(), 0);
+            visitEpoch = 1;
+        }
+        pmr::vector<uint32_t> stack(nodes.get_allocator().resource());
+        stack.push_back(start);
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+            for (uint32_t parent : node.parents) {
+                if (parent == none || visitMark[parent] == visitEpoch) continue;
+                visitMark[parent] = visitEpoch;
+                if (visit(parent)) stack.push_back(parent);
+            }
+        }
+    }
+};
+
 /**
- * @class Zoo
- * @brief Представляет зоопарк и его операции.
+ * @struct Cohort
+ * @brief Группа безымянных животных одного вида, вольера, пола и дня рождения.
  *
- * Управляет всеми аспектами зоопарка, включая животных, вольеры, работников, финансы и прогресс игры.
+ * Животные когорты не существуют по отдельности: хранится только их число и число больных.
+ * День рождения вместо возраста делает ключ когорты неизменным при старении.
  */
-class Zoo {
+struct Cohort {
+    uint64_t count;            /**< Количество животных */
+    uint64_t sick;             /**< Количество больных животных (не больше count) */
+    int32_t birthDay;          /**< Игровой день рождения (возраст = текущий день - birthDay) */
+    int32_t price;             /**< Стоимость покупки одного животного */
+    uint16_t speciesId;        /**< Идентификатор вида */
+    int16_t enclosureId;       /**< Идентификатор вольера */
+    AnimalType type;           /**< Тип животных */
+    Climate climate;           /**< Предпочитаемый климат */
+    Gender gender;             /**< Пол животных */
+};
+
+/**
+ * @class CohortStore
+ * @brief Хранилище когорт безымянных животных (популяционный режим).
+ *
+ * Память пропорциональна числу различных сочетаний вида, вольера, пола и дня рождения,
+ * а не числу животных, поэтому стада в сотни миллионов особей обрабатываются за доли миллисекунды.
+ */
+class CohortStore {
 private:
-    string name;                   /**< Название зоопарка */
-    double money;                  /**< Текущие денежные средства */
-    int food;                      /**< Доступные единицы еды */
-    double popularity;             /**< Очки популярности */
-    vector<Animal> animals;        /**< Список животных в зоопарке */
-    vector<Enclosure> enclosures;  /**< Список вольеров */
-    vector<Worker> workers;        /**< Список работников */
-    vector<Loan> loans;            /**< Список активных кредитов */
-    int day;                       /**< Текущий день в игре */
-    int visitors;                  /**< Количество посетителей сегодня */
-    int totalAnimals;              /**< Общее количество животных */
-    string specialVisitorType;     /**< Тип особых посетителей (например, "Знаменитость") */
-    int specialVisitorCount;       /**< Количество особых посетителей */
-    vector<Animal> marketAnimals;  /**< Животные, доступные для покупки */
-    int animalsBoughtToday;        /**< Животные, купленные сегодня */
+    pmr::vector<Cohort> cohorts;                      /**< Когорты */
+    pmr::unordered_map<uint64_t, uint32_t> indexByKey;/**< Ключ когорты → индекс */
 
     /**
-     * @brief Генерирует случайное число в диапазоне.
-     * @param min Минимальное значение (включительно).
-     * @param max Максимальное значение (включительно).
-     * @return Случайное целое число.
+     * @brief Формирует ключ когорты.
      */
-    static int random(int min, int max) { return min + rand() % (max - min + 1); }
+    static uint64_t makeKey(uint16_t speciesId, int enclosureId, Gender gender, int birthDay) {
+        return (static_cast<uint64_t>(speciesId) << 48) | (static_cast<uint64_t>(static_cast<uint16_t>(enclosureId)) << 32) |
+            (static_cast<uint64_t>(gender == Gender::FEMALE) << 31) | (static_cast<uint32_t>(birthDay) & 0x7FFFFFFFu);
+    }
 
+public:
     /**
-     * @brief Получает допустимый ввод пользователя в диапазоне.
-     * @param prompt Приглашение для ввода.
-     * @param minVal Минимальное допустимое значение.
-     * @param maxVal Максимальное допустимое значение.
-     * @return Допустимое целое число.
+     * @brief Создает пустое хранилище.
+     * @param resource Ресурс памяти хранилища.
      */
-    int getValidInput(const string& prompt, int minVal, int maxVal) const {
-        int value;
-        while (true) {
-            cout << prompt;
-            if (cin >> value && value >= minVal && value <= maxVal) {
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-                return value;
-            }
-            else {
-                cout << "Некорректный ввод. Введите число от " << minVal << " до " << maxVal << ".\n";
-                cin.clear();
-                cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            }
+    explicit CohortStore(pmr::memory_resource* resource = pmr::get_default_resource())
+        : cohorts(resource), indexByKey(resource) {
+    }
+
+    /**
+     * @brief Добавляет животных в когорту, создавая ее при необходимости.
+     * @param prototype Описание когорты (count и sick — добавляемые количества).
+     */
+    void add(const Cohort& prototype) {
+        uint64_t key = makeKey(prototype.speciesId, prototype.enclosureId, prototype.gender, prototype.birthDay);
+        auto it = indexByKey.find(key);
+        if (it != indexByKey.end()) {
+            cohorts[it->second].count += prototype.count;
+            cohorts[it->second].sick += prototype.sick;
+            return;
         }
+        indexByKey.emplace(key, static_cast<uint32_t>(cohorts.size()));
+        cohorts.push_back(prototype);
     }
 
     /**
-     * @brief Обновляет рынок животных новыми животными.
+     * @brief Удаляет опустевшие когорты.
      */
-    void refreshMarket() {
-        marketAnimals.clear();
-        auto available = getAvailableAnimals();
-        vector<int> indices(available.size());
-        iota(indices.begin(), indices.end(), 0);
+    void removeEmpty() {
+        auto end = remove_if(cohorts.begin(), cohorts.end(), [](const Cohort& c) { return c.count == 0; });
+        if (end == cohorts.end()) return;
+        cohorts.erase(end, cohorts.end());
+        indexByKey.clear();
+        for (uint32_t i = 0; i < cohorts.size(); ++i) {
+            const Cohort& c = cohorts[i];
+            indexByKey.emplace(makeKey(c.speciesId, c.enclosureId, c.gender, c.birthDay), i);
+        }
+    }
+
+    /**
+     * @brief Удаляет все когорты.
+     */
+    void clear() {
+        cohorts.clear();
+        indexByKey.clear();
+    }
+
+    /**
+     * @brief Получает когорты.
+     * @return Ссылка на вектор когорт.
+     */
+    pmr::vector<Cohort>& getCohorts() { return cohorts; }
 
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(indices.begin(), indices.end(), g); // Исправлено
+    /**
+     * @brief Получает когорты.
+     * @return Константная ссылка на вектор когорт.
+     */
+    const pmr::vector<Cohort>& getCohorts() const { return cohorts; }
+
+    /**
+     * @brief Проверяет, пусто ли хранилище.
+     * @return Истина, если когорт нет.
+     */
+    bool empty() const { return cohorts.empty(); }
 
-        for (int i = 0; i < min(10, (int)available.size()); ++i) {
-            marketAnimals.push_back(available[indices[i]]);
+    /**
+     * @brief Оценивает объем памяти, который может запросить создание новой когорты.
+     * @return Размер в байтах.
+     */
+    size_t growthReserve() const {
+        size_t bytes = 4 * sizeof(void*) + sizeof(pair<const uint64_t, uint32_t>);
+        if (cohorts.size() == cohorts.capacity()) bytes += max<size_t>(1, cohorts.capacity() * 2) * sizeof(Cohort);
+        if (indexByKey.size() + 1 > indexByKey.bucket_count() * indexByKey.max_load_factor()) {
+            bytes += indexByKey.bucket_count() * 2 * sizeof(void*);
         }
+        return bytes;
     }
+};
+
+/**
+ * @class GroupIndex
+ * @brief Вторичный индекс: идентификаторы животных, сгруппированные по целочисленному ключу.
+ *
+ * Добавление и удаление выполняются за амортизированное O(1): для каждого идентификатора хранятся ключ
+ * его группы и место в ней, а удаление переносит на освободившееся место последний элемент группы.
+ * Поэтому порядок внутри группы не совпадает с порядком поступления. Группы лежат в векторе подряд,
+ * начиная с наименьшего встреченного ключа, так что перебор диапазона ключей не требует поиска.
+ */
+class GroupIndex {
+private:
+    static constexpr int32_t noKey = numeric_limits<int32_t>::min(); /**< Идентификатора нет в индексе */
+
+    pmr::vector<pmr::vector<uint32_t>> groups; /**< Группы по порядку ключей, начиная с base */
+    pmr::vector<int32_t> keyById;              /**< Ключ группы по идентификатору */
+    pmr::vector<uint32_t> slotById;            /**< Место в группе по идентификатору */
+    int32_t base;                              /**< Ключ первой группы */
+    size_t largest;                            /**< Наибольший размер группы за все время */
 
 public:
     /**
-     * @brief Создает объект зоопарка.* @param n Название зоопарка.
+     * @brief Создает пустой индекс.
+     * @param resource Ресурс памяти индекса.
      */
-    Zoo(const string& n) : name(n), money(1488), food(100), popularity(50.0), day(1), visitors(0), totalAnimals(0),
-        specialVisitorType("None"), specialVisitorCount(0), animalsBoughtToday(0) {
-        workers.emplace_back("К.З", WorkerType::DIRECTOR, Worker::getSalaryForType(WorkerType::DIRECTOR));
-        workers.emplace_back("тринити", WorkerType::CLEANER, Worker::getSalaryForType(WorkerType::CLEANER), 0, vector<int>{1});
-        workers.emplace_back("морф", WorkerType::VETERINARIAN, Worker::getSalaryForType(WorkerType::VETERINARIAN), 20);
-        workers.emplace_back("диференс", WorkerType::FEEDER, Worker::getSalaryForType(WorkerType::FEEDER), 0, vector<int>{2});
-        enclosures.emplace_back(1, 5, AnimalType::HERBIVORE, Climate::TEMPERATE, 10);
-        refreshMarket();
+    explicit GroupIndex(pmr::memory_resource* resource = pmr::get_default_resource())
+        : groups(resource), keyById(resource), slotById(resource), base(0), largest(0) {
     }
 
     /**
-     * @brief Получает текущие денежные средства.
-     * @return Сумма денег.
+     * @brief Добавляет идентификатор в группу.
+     * @param key Ключ группы.
+     * @param id Идентификатор, которого еще нет в индексе.
      */
-    double getMoney() const { return money; }
+    void insert(int32_t key, uint32_t id) {
+        if (groups.empty()) base = key;
+        if (key < base) {
+            groups.insert(groups.begin(), static_cast<size_t>(base - key), pmr::vector<uint32_t>(groups.get_allocator()));
+            base = key;
+        }
+        size_t index = static_cast<size_t>(key - base);
+        if (index >= groups.size()) groups.resize(index + 1);
+        if (id >= keyById.size()) {
+            keyById.resize(id + 1, noKey);
+            slotById.resize(id + 1);
+        }
+        auto& group = groups[index];
+        keyById[id] = key;
+        slotById[id] = static_cast<uint32_t>(group.size());
+        group.push_back(id);
+        largest = max(largest, group.size());
+    }
 
     /**
-     * @brief Получает доступные единицы еды.
-     * @return Единицы еды.
+     * @brief Удаляет идентификатор из его группы.
+     * @param id Идентификатор (если его нет в индексе, ничего не происходит).
      */
-    int getFood() const { return food; }
+    void erase(uint32_t id) {
+        if (id >= keyById.size() || keyById[id] == noKey) return;
+        auto& group = groups[static_cast<size_t>(keyById[id] - base)];
+        uint32_t slot = slotById[id];
+        group[slot] = group.back();
+        slotById[group[slot]] = slot;
+        group.pop_back();
+        keyById[id] = noKey;
+    }
 
     /**
-     * @brief Получает очки популярности.
-     * @return Очки популярности.
+     * @brief Удаляет все идентификаторы.
      */
-    double getPopularity() const { return popularity; }
+    void clear() {
+        groups.clear();
+        keyById.clear();
+        slotById.clear();
+        largest = 0;
+    }
 
     /**
-     * @brief Получает текущий день.
-     * @return Текущий день.
+     * @brief Получает группу по ключу.
+     * @param key Ключ.
+     * @return Идентификаторы группы (пустой вектор, если группы нет).
      */
-    int getDay() const { return day; }
+    const pmr::vector<uint32_t>& group(int32_t key) const {
+        static const pmr::vector<uint32_t> none;
+        if (groups.empty() || key < base || key - base >= static_cast<int64_t>(groups.size())) return none;
+        return groups[static_cast<size_t>(key - base)];
+    }
 
     /**
-     * @brief Получает количество посетителей сегодня.
-     * @return Количество посетителей.
+     * @brief Перебирает группы с ключами в диапазоне по возрастанию ключа.
+     * @param low Наименьший ключ (включительно).
+     * @param high Наибольший ключ (включительно).
+     * @param visit Функция, получающая ключ и группу; возвращает ложь, чтобы остановить перебор.
      */
-    int getVisitors() const { return visitors; }
+    template<class Visit>
+    void forEachGroup(int32_t low, int32_t high, Visit&& visit) const {
+        if (groups.empty()) return;
+        int64_t first = max<int64_t>(low, base);
+        int64_t last = min<int64_t>(high, base + static_cast<int64_t>(groups.size()) - 1);
+        for (int64_t key = first; key <= last; ++key) {
+            const auto& g = groups[static_cast<size_t>(key - base)];
+            if (!g.empty() && !visit(static_cast<int32_t>(key), g)) return;
+        }
+    }
 
     /**
-     * @brief Получает общее количество животных.
-     * @return Общее количество животных.
+     * @brief Считает идентификаторы в группах с ключами в диапазоне.
+     * @param low Наименьший ключ (включительно).
+     * @param high Наибольший ключ (включительно).
+     * @return Количество идентификаторов.
      */
-    int getTotalAnimals() const { return totalAnimals; }
+    size_t count(int32_t low, int32_t high) const {
+        size_t total = 0;
+        forEachGroup(low, high, [&total](int32_t, const pmr::vector<uint32_t>& g) {
+            total += g.size();
+            return true;
+        });
+        return total;
+    }
 
     /**
-     * @brief Получает список животных.
-     * @return Ссылка на вектор животных.
+     * @brief Оценивает объем памяти, который может запросить добавление идентификатора.
+     * @param id Добавляемый идентификатор.
+     * @return Размер в байтах.
      */
-    const vector<Animal>& getAnimals() const { return animals; }
+    size_t growthReserve(uint32_t id) const {
+        size_t bytes = max<size_t>(4, largest * 2) * sizeof(uint32_t) + (groups.capacity() + 1) * 2 * sizeof(groups[0]);
+        if (id >= keyById.capacity()) bytes += max<size_t>(64, keyById.capacity() * 2) * (sizeof(int32_t) + sizeof(uint32_t));
+        return bytes;
+    }
+};
+
+/**
+ * @class PersistentVector
+ * @brief Неизменяемый вектор со структурным разделением: каждое изменение дает новую версию.
+ *
+ * Элементы лежат в листьях 32-ичного дерева. set и push_back копируют только путь от корня до листа
+ * (O(log n)), остальные узлы новая и старая версии делят через shared_ptr, поэтому хранить много
+ * версий дешево, а копирование версии — это копирование указателя на корень.
+ * @tparam T Тип элемента.
+ */
+template<class T>
+class PersistentVector {
+private:
+    static constexpr size_t bits = 5;                  /**< Бит индекса на уровень дерева */
+    static constexpr size_t width = size_t(1) << bits; /**< Ветвление */
+    static constexpr size_t mask = width - 1;          /**< Маска индекса внутри узла */
 
     /**
-     * @brief Получает список вольеров.
-     * @return Ссылка на вектор вольеров.
+     * @struct Node
+     * @brief Узел дерева: внутренний хранит детей, лист — элементы.
+     */
+    struct Node {
+        vector<shared_ptr<const Node>> children; /**< Дети внутреннего узла */
+        vector<T> values;                        /**< Элементы листа */
+    };
+
+    shared_ptr<const Node> root; /**< Корень (nullptr у пустого вектора) */
+    size_t count = 0;            /**< Количество элементов */
+    size_t shift = 0;            /**< Сдвиг индекса для корня (0 — корень является листом) */
+
+    static shared_ptr<const Node> assign(const shared_ptr<const Node>& node, size_t level, size_t index, T&& value) {
+        auto copy = make_shared<Node>(*node);
+        if (level == 0) copy->values[index & mask] = std::move(value);
+        else {
+            auto& child = copy->children[(index >> level) & mask];
+            child = assign(child, level - bits, index, std::move(value));
+        }
+        return copy;
+    }
+
+    static shared_ptr<const Node> append(const shared_ptr<const Node>& node, size_t level, size_t index, T&& value) {
+        auto copy = node ? make_shared<Node>(*node) : make_shared<Node>();
+        if (level == 0) copy->values.push_back(std::move(value));
+        else {
+            size_t slot = (index >> level) & mask;
+            if (slot == copy->children.size()) copy->children.push_back(append(nullptr, level - bits, index, std::move(value)));
+            else copy->children[slot] = append(copy->children[slot], level - bits, index, std::move(value));
+        }
+        return copy;
+    }
+
+public:
+    /**
+     * @brief Строит вектор из диапазона за O(n), без промежуточных версий.
+     * @param first Начало диапазона.
+     * @param last Конец диапазона.
+     * @return Вектор с элементами диапазона.
      */
-    const vector<Enclosure>& getEnclosures() const { return enclosures; }
+    template<class It>
+    static PersistentVector build(It first, It last) {
+        PersistentVector result;
+        vector<shared_ptr<const Node>> level;
+        while (first != last) {
+            auto leaf = make_shared<Node>();
+            for (; first != last && leaf->values.size() < width; ++first) leaf->values.push_back(*first);
+            result.count += leaf->values.size();
+            level.push_back(std::move(leaf));
+        }
+        while (level.size() > 1) {
+            vector<shared_ptr<const Node>> parents;
+            for (size_t i = 0; i < level.size(); i += width) {
+                auto parent = make_shared<Node>();
+                parent->children.assign(level.begin() + i, level.begin() + min(i + width, level.size()));
+                parents.push_back(std::move(parent));
+            }
+            level.swap(parents);
+            result.shift += bits;
+        }
+        if (!level.empty()) result.root = level.front();
+        return result;
+    }
 
     /**
-     * @brief Получает список работников.
-     * @return Ссылка на вектор работников.
+     * @brief Получает количество элементов.
+     * @return Размер вектора.
      */
-    const vector<Worker>& getWorkers() const { return workers; }
+    size_t size() const { return count; }
 
     /**
-     * @brief Отображает текущий статус зоопарка.
+     * @brief Получает элемент.
+     * @param index Индекс (меньше size()).
+     * @return Ссылка на элемент (действительна, пока жива версия).
      */
-    void displayStatus() const {
-        cout << "\n--- Статус зоопарка \"" << name << "\" (День " << day << ") ---\n";
-        cout << "Деньги: $" << money << endl;
-        cout << "Еда: " << food << " единиц" << endl;
-        cout << "Популярность: " << popularity << endl;
-        cout << "Всего животных: " << totalAnimals << endl;
-        cout << "Посетителей сегодня: " << visitors << endl;
-        if (specialVisitorType != "None") {
-            cout << "Особые гости: " << specialVisitorCount << " " << (specialVisitorType == "Celebrity" ? "Знаменитостей" : "Фотографов") << endl;
+    const T& operator[](size_t index) const {
+        const Node* node = root.get();
+        for (size_t level = shift; level > 0; level -= bits) node = node->children[(index >> level) & mask].get();
+        return node->values[index & mask];
+    }
+
+    /**
+     * @brief Заменяет элемент.
+     * @param index Индекс (меньше size()).
+     * @param value Новое значение.
+     * @return Новая версия; текущая не меняется.
+     */
+    PersistentVector set(size_t index, T value) const {
+        PersistentVector result = *this;
+        result.root = assign(root, shift, index, std::move(value));
+        return result;
+    }
+
+    /**
+     * @brief Добавляет элемент в конец.
+     * @param value Элемент.
+     * @return Новая версия; текущая не меняется.
+     */
+    PersistentVector push_back(T value) const {
+        PersistentVector result = *this;
+        if (root && count == (size_t(1) << (shift + bits))) {
+            auto top = make_shared<Node>();
+            top->children.push_back(root);
+            result.root = std::move(top);
+            result.shift += bits;
         }
-        cout << "Работников: " << workers.size() << endl;
-        cout << "Вольеров: " << enclosures.size() << endl;
+        result.root = append(result.root, result.shift, count, std::move(value));
+        result.count++;
+        return result;
     }
 
     /**
-     * @brief Возвращает список животных, доступных для покупки.
-     * @return Вектор доступных животных.
+     * @brief Перебирает элементы по порядку.
+     * @param visit Функция, получающая элемент.
      */
-    static vector<Animal> getAvailableAnimals() {
-        return {
-            {"Олень", "Олень", 10, 200, Climate::TEMPERATE, 150, AnimalType::HERBIVORE, (rand() % 2 ? Gender::MALE : Gender::FEMALE)},
-            {"Слон", "Слон", 15, 6000, Climate::TROPICAL, 350, AnimalType::HERBIVORE, (rand() % 2 ? Gender::MALE : Gender::FEMALE)},
-            {"Жираф", "Жираф", 12, 1800, Climate::TROPICAL, 300, AnimalType::HERBIVORE, (rand() % 2 ? Gender::MALE : Gender::FEMALE)},
-            {"Зебра", "Зебра", 8, 400, Climate::TROPICAL, 200, AnimalType::HERBIVORE, (rand() % 2 ? Gender::MALE : Gender::FEMALE)},
-            {"Кролик", "Кролик", 3, 5, Climate::TEMPERATE, 100, AnimalType::HERBIVORE, (rand() % 2 ? Gender::MALE : Gender::FEMALE)},
-            {"Лев", "Лев", 10, 300, Climate::TROPICAL, 400, AnimalType::CARNIVORE, (rand() % 2 ? Gender::MALE : Gender::FEMALE)},{"Волк", "Волк", 7, 150, Climate::TEMPERATE, 250, AnimalType::CARNIVORE, (rand() % 2 ? Gender::MALE : Gender::FEMALE)},
-            {"Белый медведь", "Белый медведь", 14, 800, Climate::ARCTIC, 450, AnimalType::CARNIVORE, (rand() % 2 ? Gender::MALE : Gender::FEMALE)},
-            {"Тигр", "Тигр", 9, 350, Climate::TROPICAL, 350, AnimalType::CARNIVORE, (rand() % 2 ? Gender::MALE : Gender::FEMALE)},
-            {"Лисица", "Лисица", 5, 100, Climate::TEMPERATE, 200, AnimalType::CARNIVORE, (rand() % 2 ? Gender::MALE : Gender::FEMALE)}
-        };
+    template<class Visit>
+    void forEach(Visit&& visit) const {
+        if (root) forEachIn(*root, shift, visit);
     }
 
+private:
+    template<class Visit>
+    static void forEachIn(const Node& node, size_t level, Visit& visit) {
+        if (level == 0) {
+            for (const T& value : node.values) visit(value);
+            return;
+        }
+        for (const auto& child : node.children) forEachIn(*child, level - bits, visit);
+    }
+};
+
+/**
+ * @class Enclosure
+ * @brief Представляет вольер в зоопарке.
+ *
+ * Управляет составом животных с определенной вместимостью, типом животных и климатом. Вольер хранит только
+ * идентификаторы животных; сами записи существуют в одном экземпляре в зоопарке. Безымянные животные
+ * популяционного режима учитываются только количеством (см. CohortStore).
+ *
+ * Животные занимают места в порядке поступления, и этот порядок совпадает с их порядком в зоопарке.
+ * Для каждого места хранятся признаки (болезнь, хищник, готовность к размножению, женский пол) в битовых
+ * наборах по 64 места в слове, поэтому сводки считаются подсчетом битов, а массовые изменения — операциями
+ * над словами.
+ */
+class Enclosure {
+public:
+    using allocator_type = pmr::polymorphic_allocator<int>; /**< Аллокатор списка животных */
+
     /**
-     * @brief Управляет операциями с животными (покупка, продажа, переименование и т.д.).
+     * @enum Flag
+     * @brief Признаки животных, хранимые битовыми наборами.
      */
-    void manageAnimals() {
-        while (true) {
-            string prompt = "\nУправление животными:\n"
-                "1. Купить животное\n"
-                "2. Продать животное\n"
-                "3. Просмотреть информацию о животных\n"
-                "4. Переименовать животное\n"
-                "5. Обновить рынок животных ($50)\n"
-                "6. Назад\n"
-                "Выберите действие: ";
-            int choice = getValidInput(prompt, 1, 6);
-            if (choice == 1) {
-                if (day > 10 && animalsBoughtToday >= 1) {
-                    cout << "После 10-го дня можно купить только одно животное в день.\n";
-                    continue;
-                }
-                if (marketAnimals.empty()) {
-                    cout << "Рынок пуст. Обновите рынок.\n";
-                    continue;
-                }
-                cout << "\nДоступные животные для покупки:\n";
-                for (size_t i = 0; i < marketAnimals.size(); ++i) {
-                    cout << i + 1 << ". " << marketAnimals[i].getSpecies()
-                        << " (" << marketAnimals[i].getDisplayName() << "), Цена: $" << marketAnimals[i].getPrice()
-                        << ", Пол: " << (marketAnimals[i].getGender() == Gender::MALE ? "М" : "Ж")
-                        << ", Климат: ";
-                    switch (marketAnimals[i].getPreferredClimate()) {
-                    case Climate::TROPICAL: cout << "Тропический"; break;
-                    case Climate::TEMPERATE: cout << "Умеренный"; break;
-                    case Climate::ARCTIC: cout << "Арктический"; break;
-                    }
-                    cout << ", Тип: " << (marketAnimals[i].getType() == AnimalType::HERBIVORE ? "Травоядное" : "Хищник") << "\n";
-                }
-                int animalChoice = getValidInput("Выберите животное для покупки (1-" + to_string(marketAnimals.size()) + ") или 0 для отмены: ", 0, marketAnimals.size());
-                if (animalChoice >= 1 && animalChoice <= static_cast<int>(marketAnimals.size())) {
-                    Animal selected = marketAnimals[animalChoice - 1];
-                    if (money >= selected.getPrice()) {
-                        cout << "Выберите вольер (ID) для " << selected.getDisplayName() << ":\n";
-                        bool validEnclosure = false;
-                        vector<int> validEnclosureIds;
-                        for (const auto& enc : enclosures) {
-                            if (enc.canAddAnimal(selected)) {
-                                cout << "ID " << enc.getId() << " (" << enc.getAnimalCount() << "/" << enc.getCapacity() << " животных)\n";
-                                validEnclosureIds.push_back(enc.getId());
-                                validEnclosure = true;
-                            }
-                        }
-                        if (!validEnclosure) {
-                            cout << "Нет подходящих вольеров для этого животного.\n";
-                            continue;
-                        }
-                        int encId = getValidInput("Введите ID вольера: ", 1, enclosures.back().getId());
-                        bool placed = false;
-                        for (auto& enc : enclosures) {
-                            if (enc.getId() == encId && enc.canAddAnimal(selected)) {
-                                selected.setEnclosureId(encId);
-                                enc.addAnimal(selected);
-                                animals.push_back(selected);
-                                money -= selected.getPrice();
-                                totalAnimals++;
-                                animalsBoughtToday++;
-                                marketAnimals.erase(marketAnimals.begin() + (animalChoice - 1));
-                                cout << selected.getDisplayName() << " куплено и размещено в вольере " << encId << ".\n";
-                                placed = true;
-                                break;
-                            }
-                        }
-                        if (!placed) cout << "Неверный ID вольера или неподходящий вольер.\n";
-                    }
-                    else cout << "Недостаточно денег!\n";
-                }
-            }
-            else if (choice == 2) {
-                if (animals.empty()) {
-                    cout << "Нет животных для продажи.\n";
-                    continue;
-                }
-                for (size_t i = 0; i < animals.size(); ++i) {
-                    cout << i + 1 << ". " << animals[i].getSpecies() << " (" << animals[i].getDisplayName() << "), ID вольера: " << animals[i].getEnclosureId() << "\n";
-                }
-                int sellChoice = getValidInput("Выберите животное для продажи (1-" + to_string(animals.size()) + ") или 0 для отмены: ", 0, animals.size());
-                if (sellChoice >= 1 && sellChoice <= static_cast<int>(animals.size())) {
-                    Animal sold = animals[sellChoice - 1];
-                    money += sold.getPrice() / 2;
-                    for (auto& enc : enclosures) {
-                        if (enc.getId() == sold.getEnclosureId()) {
-                            enc.removeAnimal(sold.getUniqueId());
-                            break;
-                        }
-                    }
-                    animals.erase(animals.begin() + (sellChoice - 1));
-                    totalAnimals--;
-                    cout << sold.getDisplayName() << " продано за $" << sold.getPrice() / 2 << ".\n";
-                }
-            }
-            else if (choice == 3) {
-                if (animals.empty()) {
-                    cout << "В зоопарке нет животных.\n";
-                    continue;
-                }
-                cout << "\nИнформация о животных:\n";
-                for (const auto& animal : animals) {
-                    cout << "Вид: " << animal.getSpecies() << ", Имя: " << animal.getDisplayName()
-                        << ", Возраст: " << animal.getAgeDays() << " дней"
-                        << ", Пол: " << (animal.getGender() == Gender::MALE ? "М" : "Ж")
-                        << ", Вес: " << animal.getWeight() << " кг"
-                        << ", Климат: ";
-                    switch (animal.getPreferredClimate()) {
-                    case Climate::TROPICAL: cout << "Тропический"; break;
-                    case Climate::TEMPERATE: cout << "Умеренный"; break;
-                    case Climate::ARCTIC: cout << "Арктический"; break;
-                    }
-                    cout << ", Тип: " << (animal.getType() == AnimalType::HERBIVORE ? "Травоядное" : "Хищник")
-                        << ", ID вольера: " << animal.getEnclosureId() << ", Дней с покупки: " << animal.getDaysSincePurchase()
-                        << ", Болен: " << (animal.getIsSick() ? "Да" : "Нет");
-                    if (animal.getIsBornInZoo()) {
-                        cout << ", Родители: " << animal.getParents().first << " и " << animal.getParents().second;
-                    }
-                    cout << "\n";
-                }
-            }
-            else if (choice == 4) {
-                if (animals.empty()) {
-                    cout << "В зоопарке нет животных.\n";
-                    continue;
-                }
-                for (size_t i = 0; i < animals.size(); ++i) {
-                    cout << i + 1 << ". " << animals[i].getSpecies() << " (" << animals[i].getDisplayName() << "), ID вольера: " << animals[i].getEnclosureId() << "\n";
-                }int renameChoice = getValidInput("Выберите животное для переименования (1-" + to_string(animals.size()) + ") или 0 для отмены: ", 0, animals.size());
-                if (renameChoice >= 1 && renameChoice <= static_cast<int>(animals.size())) {
-                    string newName;
-                    cin.ignore();
-                    cout << "Введите новое имя для " << animals[renameChoice - 1].getDisplayName() << ": ";
-                    getline(cin, newName);
-                    if (!newName.empty()) {
-                        animals[renameChoice - 1].setDisplayName(newName);
-                        for (auto& enc : enclosures) {
-                            if (enc.getId() == animals[renameChoice - 1].getEnclosureId()) {
-                                enc.updateAnimal(animals[renameChoice - 1]);
-                                break;
-                            }
-                        }
-                        cout << "Животное переименовано в " << newName << ".\n";
-                    }
-                    else cout << "Имя не может быть пустым.\n";
-                }
-            }
-            else if (choice == 5) {
-                if (money >= 50) {
-                    money -= 50;
-                    refreshMarket();
-                    cout << "Рынок животных обновлён за $50.\n";
-                }
-                else cout << "Недостаточно денег для обновления рынка.\n";
-            }
-            else if (choice == 6) break;
+    enum Flag : size_t {
+        SICK,              /**< Болеет */
+        CARNIVORE,         /**< Хищник */
+        BREEDING_ELIGIBLE, /**< Достаточно взрослое для размножения */
+        FEMALE,            /**< Самка */
+        FLAG_COUNT         /**< Количество признаков */
+    };
+
+private:
+    int id;                    /**< Уникальный идентификатор вольера */
+    int capacity;              /**< Максимальное количество животных в вольере */
+    AnimalType animalType;     /**< Тип животных, разрешенных в вольере */
+    Climate climate;           /**< Климат вольера */
+    int dailyCost;             /**< Ежедневная стоимость содержания */
+    pmr::vector<int> animalIds;/**< Идентификаторы животных в вольере */
+    pmr::vector<uint64_t> flags; /**< Признаки по местам: слово w признака f — flags[w * FLAG_COUNT + f] */
+    uint64_t herdSize;         /**< Количество безымянных животных когорт в вольере */
+
+    uint64_t& word(size_t w, Flag f) { return flags[w * FLAG_COUNT + f]; }
+    uint64_t word(size_t w, Flag f) const { return flags[w * FLAG_COUNT + f]; }
+
+    /**
+     * @brief Удаляет бит места из набора, сдвигая следующие места на одно назад.
+     * @param f Признак.
+     * @param slot Место.
+     */
+    void eraseBit(Flag f, size_t slot) {
+        size_t first = slot / 64, words = flags.size() / FLAG_COUNT;
+        uint64_t below = (1ull << (slot % 64)) - 1;
+        word(first, f) = (word(first, f) & below) | ((word(first, f) >> 1) & ~below);
+        for (size_t w = first + 1; w < words; ++w) {
+            word(w - 1, f) |= word(w, f) << 63;
+            word(w, f) >>= 1;
         }
     }
 
+public:
     /**
-     * @brief Управляет операциями с работниками (найм, увольнение, назначение на вольеры).
+     * @brief Создает объект вольера.
+     * @param i Идентификатор вольера.
+     * @param cap Максимальная вместимость.
+     * @param t Тип разрешенных животных.
+     * @param c Климат вольера.
+     * @param cost Ежедневная стоимость содержания.
      */
-    void manageWorkers() {
-        while (true) {
-            string prompt = "\nУправление работниками:\n"
-                "1. Нанять работника\n"
-                "2. Просмотреть работников\n"
-                "3. Уволить работника\n"
-                "4. Назначить работника на вольер\n"
-                "5. Назад\n"
-                "Выберите действие: ";
-            int choice = getValidInput(prompt, 1, 5);
-            if (choice == 1) {
-                string name;
-                cin.ignore();
-                while (true) {
-                    cout << "Введите имя работника: ";
-                    getline(cin, name);
-                    if (!name.empty()) break;
-                    cout << "Имя работника не может быть пустым. Попробуйте снова.\n";
-                }
-                cout << "Выберите должность:\n";
-                cout << "1. Ветеринар (до 20 животных)\n";
-                cout << "2. Уборщик (1 вольер)\n";
-                cout << "3. Кормильщик (до 2 вольеров)\n";
-                int posChoice = getValidInput("Выберите должность (1-3): ", 1, 3);
-                WorkerType position;
-                int maxAnimals = 0;
-                switch (posChoice) {
-                case 1: position = WorkerType::VETERINARIAN; maxAnimals = 20; break;
-                case 2: position = WorkerType::CLEANER; maxAnimals = 0; break;
-                case 3: position = WorkerType::FEEDER; maxAnimals = 0; break;
-                default: position = WorkerType::CLEANER;
-                }
-                int salary = Worker::getSalaryForType(position);
-                vector<int> enclosureIds;
-                Worker newWorker(name, position, salary, maxAnimals, enclosureIds);
-                cout << name << " нанят как " << newWorker.getTypeString() << ".\n";
-                if (enclosures.empty()) {
-                    cout << "Нет вольеров для назначения.\n";
+    Enclosure(int i, int cap, AnimalType t, Climate c, int cost)
+        : Enclosure(allocator_arg, {}, i, cap, t, c, cost) {
+    }
+
+    /**
+     * @brief Создает объект вольера, размещая список животных через указанный аллокатор.
+     * @param alloc Аллокатор списка животных.
+     *
+     * Остальные параметры совпадают с основным конструктором.
+     */
+    Enclosure(allocator_arg_t, const allocator_type& alloc, int i, int cap, AnimalType t, Climate c, int cost)
+        : id(i), capacity(cap), animalType(t), climate(c), dailyCost(cost), animalIds(alloc), flags(alloc), herdSize(0) {
+    }
+
+    Enclosure(const Enclosure&) = default;
+    Enclosure(Enclosure&&) = default;
+    Enclosure& operator=(const Enclosure&) = default;
+    Enclosure& operator=(Enclosure&&) = default;
+
+    /**
+     * @brief Копирует вольер, размещая список животных через указанный аллокатор.
+     * @param alloc Аллокатор списка животных.
+     * @param other Копируемый вольер.
+     */
+    Enclosure(allocator_arg_t, const allocator_type& alloc, const Enclosure& other)
+        : id(other.id), capacity(other.capacity), animalType(other.animalType), climate(other.climate),
+        dailyCost(other.dailyCost), animalIds(other.animalIds, alloc), flags(other.flags, alloc), herdSize(other.herdSize) {
+    }
+
+    /**
+     * @brief Перемещает вольер, размещая список животных через указанный аллокатор.
+     * @param alloc Аллокатор списка животных.
+     * @param other Перемещаемый вольер.
+     */
+    Enclosure(allocator_arg_t, const allocator_type& alloc, Enclosure&& other)
+        : id(other.id), capacity(other.capacity), animalType(other.animalType), climate(other.climate),
+        dailyCost(other.dailyCost), animalIds(std::move(other.animalIds), alloc), flags(std::move(other.flags), alloc),
+        herdSize(other.herdSize) {
+    }
+
+    /**
+     * @brief Получает аллокатор списка животных.
+     * @return Аллокатор вольера.
+     */
+    allocator_type get_allocator() const { return animalIds.get_allocator(); }
+
+    /**
+     * @brief Получает идентификатор вольера.
+     * @return Идентификатор вольера.
+     */
+    int getId() const { return id; }
+
+    /**
+     * @brief Получает вместимость.
+     * @return Максимальное количество животных.
+     */
+    int getCapacity() const { return capacity; }
+
+    /**
+     * @brief Получает тип животных.
+     * @return Тип разрешенных животных.
+     */
+    AnimalType getAnimalType() const { return animalType; }
+
+    /**
+     * @brief Получает климат.
+     * @return Климат вольера.
+     */
+    Climate getClimate() const { return climate; }
+
+    /**
+     * @brief Получает ежедневную стоимость.
+     * @return Ежедневная стоимость содержания.
+     */
+    int getDailyCost() const { return dailyCost; }
+
+    /**
+     * @brief Получает количество животных.
+     * @return Количество животных в вольере.
+     */
+    size_t getAnimalCount() const { return animalIds.size() + static_cast<size_t>(herdSize); }
+
+    /**
+     * @brief Получает количество безымянных животных когорт.
+     * @return Количество животных когорт в вольере.
+     */
+    uint64_t getHerdSize() const { return herdSize; }
+
+    /**
+     * @brief Получает идентификаторы животных.
+     * @return Ссылка на вектор идентификаторов животных в вольере.
+     */
+    const pmr::vector<int>& getAnimalIds() const { return animalIds; }
+
+    /**
+     * @brief Проверяет, можно ли добавить животное в вольер.
+     * @param animal Животное для проверки.
+     * @return Истина, если животное можно добавить (соответствует типу, климату и вместимость не превышена).
+     */
+    bool canAddAnimal(const Animal& animal) const {
+        return canAddHerd(animal.getType(), animal.getPreferredClimate(), 1);
+    }
+
+    /**
+     * @brief Проверяет, можно ли добавить в вольер несколько животных когорты.
+     * @param t Тип животных.
+     * @param c Предпочитаемый климат животных.
+     * @param count Количество животных.
+     * @return Истина, если тип и климат подходят и хватает вместимости.
+     */
+    bool canAddHerd(AnimalType t, Climate c, uint64_t count) const {
+        return getAnimalCount() + count <= static_cast<size_t>(capacity) && t == animalType && c == climate;
+    }
+
+    /**
+     * @brief Добавляет животное в вольер.
+     * @param animal Животное для добавления.
+     */
+    void addAnimal(const Animal& animal) {
+        size_t slot = animalIds.size();
+        if (slot % 64 == 0) flags.resize(flags.size() + FLAG_COUNT, 0);
+        animalIds.push_back(animal.getUniqueId());
+        setFlag(slot, SICK, animal.getIsSick());
+        setFlag(slot, CARNIVORE, animal.getType() == AnimalType::CARNIVORE);
+        setFlag(slot, BREEDING_ELIGIBLE, animal.canBreed());
+        setFlag(slot, FEMALE, animal.getGender() == Gender::FEMALE);
+    }
+
+    /**
+     * @brief Удаляет животное из вольера.
+     * @param uniqueId Уникальный идентификатор животного для удаления.
+     */
+    void removeAnimal(int uniqueId) {
+        auto it = find(animalIds.begin(), animalIds.end(), uniqueId);
+        if (it != animalIds.end()) removeSlot(static_cast<size_t>(it - animalIds.begin()));
+    }
+
+    /**
+     * @brief Удаляет животное, занимающее место; следующие животные сдвигаются на одно место назад.
+     * @param slot Место.
+     */
+    void removeSlot(size_t slot) {
+        animalIds.erase(animalIds.begin() + static_cast<ptrdiff_t>(slot));
+        for (size_t f = 0; f < FLAG_COUNT; ++f) eraseBit(static_cast<Flag>(f), slot);
+        if (animalIds.size() % 64 == 0) flags.resize(flags.size() - FLAG_COUNT);
+    }
+
+    /**
+     * @brief Устанавливает признак животного на месте.
+     * @param slot Место.
+     * @param f Признак.
+     * @param value Значение.
+     */
+    void setFlag(size_t slot, Flag f, bool value) {
+        uint64_t bit = 1ull << (slot % 64);
+        if (value) word(slot / 64, f) |= bit;
+        else word(slot / 64, f) &= ~bit;
+    }
+
+    /**
+     * @brief Проверяет признак животного на месте.
+     * @param slot Место.
+     * @param f Признак.
+     * @return Значение признака.
+     */
+    bool testFlag(size_t slot, Flag f) const { return (word(slot / 64, f) >> (slot % 64)) & 1; }
+
+    /**
+     * @brief Сбрасывает признак у всех животных вольера.
+     * @param f Признак.
+     */
+    void clearFlag(Flag f) {
+        for (size_t w = 0; w < flags.size() / FLAG_COUNT; ++w) word(w, f) = 0;
+    }
+
+    /**
+     * @brief Подсчитывает животных с признаком.
+     * @param f Признак.
+     * @return Количество животных (без животных когорт).
+     */
+    size_t countFlag(Flag f) const {
+        size_t total = 0;
+        for (size_t w = 0; w < flags.size() / FLAG_COUNT; ++w) total += static_cast<size_t>(popcount(word(w, f)));
+        return total;
+    }
+
+    /**
+     * @brief Рассчитывает дневную потребность в еде отдельных животных (травоядному 1, хищнику 2).
+     * @return Единицы еды.
+     */
+    long long foodDemand() const { return static_cast<long long>(animalIds.size() + countFlag(CARNIVORE)); }
+
+    /**
+     * @brief Проверяет, есть ли в вольере готовые к размножению самка и самец.
+     * @return Истина, если пару можно составить.
+     */
+    bool hasBreedingPair() const {
+        uint64_t females = 0, males = 0;
+        for (size_t w = 0; w < flags.size() / FLAG_COUNT; ++w) {
+            females |= word(w, BREEDING_ELIGIBLE) & word(w, FEMALE);
+            males |= word(w, BREEDING_ELIGIBLE) & ~word(w, FEMALE);
+        }
+        return females != 0 && males != 0;
+    }
+
+    /**
+     * @brief Добавляет в вольер животных когорты.
+     * @param count Количество животных.
+     */
+    void addHerd(uint64_t count) { herdSize += count; }
+
+    /**
+     * @brief Убирает из вольера животных когорты.
+     * @param count Количество животных.
+     */
+    void removeHerd(uint64_t count) { herdSize -= min(count, herdSize); }
+};
+
+/**
+ * @class Worker
+ * @brief Представляет работника зоопарка.
+ *
+ * Хранит имя, назначенные вольеры и счетчики дней. Роль (зарплата, ограничения, действие за день)
+ * задается не полем работника, а бригадой, в которой он числится (см. Crew и WorkerRoster).
+ */
+class Worker {
+public:
+    using allocator_type = pmr::polymorphic_allocator<char>; /**< Аллокатор имени и списка вольеров */
+
+private:
+    pmr::string name;              /**< Имя работника */
+    pmr::vector<int> assignedEnclosures;/**< Идентификаторы назначенных вольеров */
+    int daysAssigned;              /**< Количество дней назначения на вольеры */
+    int daysWorked;                /**< Общее количество отработанных дней */
+
+public:
+    /**
+     * @brief Создает объект работника.
+     * @param n Имя работника.
+     * @param encs Идентификаторы назначенных вольеров (по умолчанию пусто).
+     * @param daysAss Дни назначения на вольеры (по умолчанию 0).
+     * @param daysW Общее количество отработанных дней (по умолчанию 0).
+     */
+    Worker(string_view n, const vector<int>& encs = {}, int daysAss = 0, int daysW = 0)
+        : Worker(allocator_arg, {}, n, encs, daysAss, daysW) {
+    }
+
+    /**
+     * @brief Создает объект работника, размещая имя и список вольеров через указанный аллокатор.
+     * @param alloc Аллокатор работника.
+     *
+     * Остальные параметры совпадают с основным конструктором.
+     */
+    Worker(allocator_arg_t, const allocator_type& alloc, string_view n, const vector<int>& encs = {}, int daysAss = 0,
+        int daysW = 0)
+        : name(n, alloc), assignedEnclosures(encs.begin(), encs.end(), alloc), daysAssigned(daysAss), daysWorked(daysW) {
+    }
+
+    Worker(const Worker&) = default;
+    Worker(Worker&&) = default;
+    Worker& operator=(const Worker&) = default;
+    Worker& operator=(Worker&&) = default;
+
+    /**
+     * @brief Копирует работника, размещая имя и список вольеров через указанный аллокатор.
+     * @param alloc Аллокатор работника.
+     * @param other Копируемый работник.
+     */
+    Worker(allocator_arg_t, const allocator_type& alloc, const Worker& other)
+        : name(other.name, alloc), assignedEnclosures(other.assignedEnclosures, alloc), daysAssigned(other.daysAssigned),
+        daysWorked(other.daysWorked) {
+    }
+
+    /**
+     * @brief Перемещает работника, размещая имя и список вольеров через указанный аллокатор.
+     * @param alloc Аллокатор работника.
+     * @param other Перемещаемый работник.
+     */
+    Worker(allocator_arg_t, const allocator_type& alloc, Worker&& other)
+        : name(std::move(other.name), alloc), assignedEnclosures(std::move(other.assignedEnclosures), alloc),
+        daysAssigned(other.daysAssigned), daysWorked(other.daysWorked) {
+    }
+
+    /**
+     * @brief Получает аллокатор работника.
+     * @return Аллокатор имени и списка вольеров.
+     */
+    allocator_type get_allocator() const { return name.get_allocator(); }
+
+    /**
+     * @brief Получает имя работника.
+     * @return Имя работника.
+     */
+    const pmr::string& getName() const { return name; }
+
+    /**
+     * @brief Получает идентификаторы назначенных вольеров.
+     * @return Ссылка на вектор идентификаторов вольеров.
+     */
+    const pmr::vector<int>& getAssignedEnclosures() const { return assignedEnclosures; }
+
+    /**
+     * @brief Получает количество дней назначения.
+     * @return Дни назначения.
+     */
+    int getDaysAssigned() const { return daysAssigned; }
+
+    /**
+     * @brief Получает общее количество отработанных дней.
+     * @return Отработанные дни.
+     */
+    int getDaysWorked() const { return daysWorked; }
+
+    /**
+     * @brief Назначает вольер работнику.
+     * @param encId Идентификатор вольера для назначения.
+     */
+    void assignEnclosure(int encId) {
+        if (find(assignedEnclosures.begin(), assignedEnclosures.end(), encId) == assignedEnclosures.end()) {
+            assignedEnclosures.push_back(encId);
+        }
+    }
+
+    /**
+     * @brief Очищает все назначенные вольеры.
+     */
+    void clearAssignedEnclosures() { assignedEnclosures.clear(); }
+
+    /**
+     * @brief Устанавливает количество дней назначения.
+     * @param days Количество дней.
+     */
+    void setDaysAssigned(int days) { daysAssigned = days; }
+
+    /**
+     * @brief Уменьшает дни назначения (если положительны).
+     */
+    void decrementDaysAssigned() { if (daysAssigned > 0) daysAssigned--; }
+
+    /**
+     * @brief Увеличивает общее количество отработанных дней.
+     */
+    void incrementDaysWorked() { daysWorked++; }
+};
+
+/**
+ * @enum DailyEffect
+ * @brief Действие, которое работник роли выполняет каждый день.
+ */
+enum class DailyEffect {
+    NONE,        /**< Только отрабатывает смену */
+    TREAT_SICK   /**< Лечит больных животных в назначенных вольерах */
+};
+
+/**
+ * @struct DirectorRole
+ * @brief Роль директора: не назначается на вольеры и не может быть уволен.
+ */
+struct DirectorRole {
+    static constexpr WorkerType type = WorkerType::DIRECTOR;
+    static constexpr const char* title = "Директор";
+    static constexpr int salary = 60;
+    static constexpr size_t maxEnclosures = 0;
+    static constexpr int maxAnimals = 0;
+    static constexpr DailyEffect effect = DailyEffect::NONE;
+};
+
+/**
+ * @struct VeterinarianRole
+ * @brief Роль ветеринара: лечит до 20 животных в назначенных вольерах.
+ */
+struct VeterinarianRole {
+    static constexpr WorkerType type = WorkerType::VETERINARIAN;
+    static constexpr const char* title = "Ветеринар";
+    static constexpr int salary = 50;
+    static constexpr size_t maxEnclosures = numeric_limits<size_t>::max();
+    static constexpr int maxAnimals = 20;
+    static constexpr DailyEffect effect = DailyEffect::TREAT_SICK;
+};
+
+/**
+ * @struct CleanerRole
+ * @brief Роль уборщика: отвечает за один вольер.
+ */
+struct CleanerRole {
+    static constexpr WorkerType type = WorkerType::CLEANER;
+    static constexpr const char* title = "Уборщик";
+    static constexpr int salary = 30;
+    static constexpr size_t maxEnclosures = 1;
+    static constexpr int maxAnimals = 0;
+    static constexpr DailyEffect effect = DailyEffect::NONE;
+};
+
+/**
+ * @struct FeederRole
+ * @brief Роль кормильца: отвечает за два вольера.
+ */
+struct FeederRole {
+    static constexpr WorkerType type = WorkerType::FEEDER;
+    static constexpr const char* title = "Кормилец";
+    static constexpr int salary = 40;
+    static constexpr size_t maxEnclosures = 2;
+    static constexpr int maxAnimals = 0;
+    static constexpr DailyEffect effect = DailyEffect::NONE;
+};
+
+/**
+ * @struct RoleInfo
+ * @brief Параметры роли для кода, выбирающего роль во время выполнения (меню).
+ */
+struct RoleInfo {
+    WorkerType type;           /**< Тип работника */
+    const char* title;         /**< Название должности */
+    int salary;                /**< Ежедневная зарплата */
+    size_t maxEnclosures;      /**< Наибольшее число назначенных вольеров */
+    int maxAnimals;            /**< Наибольшее число животных на попечении (0 — без ограничения) */
+};
+
+/**
+ * @class Crew
+ * @brief Работники одной роли в непрерывном массиве.
+ * @tparam Role Тип политики роли (DirectorRole, VeterinarianRole и т.д.).
+ */
+template<class Role>
+class Crew {
+public:
+    using RoleType = Role;     /**< Политика роли */
+
+    /** @brief Параметры роли для меню. */
+    static constexpr RoleInfo info{ Role::type, Role::title, Role::salary, Role::maxEnclosures, Role::maxAnimals };
+
+    pmr::vector<Worker> members; /**< Работники роли в порядке найма */
+
+    explicit Crew(pmr::memory_resource* r) : members(r) {}
+
+    /**
+     * @brief Рассчитывает дневную зарплату бригады.
+     * @return Сумма зарплат.
+     */
+    int payroll() const { return Role::salary * static_cast<int>(members.size()); }
+};
+
+/**
+ * @class WorkerRoster
+ * @brief Все работники зоопарка, разложенные по бригадам ролей.
+ *
+ * Ежедневная обработка идет по бригадам (forEachCrew), так что поведение роли известно при компиляции
+ * и цикл по работникам не содержит ветвлений по типу. Меню обращаются к работникам по сквозному
+ * номеру: сначала директор, затем ветеринары, уборщики и кормильцы.
+ */
+class WorkerRoster {
+public:
+    /**
+     * @struct Entry
+     * @brief Работник вместе с параметрами его роли.
+     */
+    struct Entry {
+        Worker& worker;        /**< Работник */
+        const RoleInfo& role;  /**< Параметры роли */
+    };
+
+private:
+    Crew<DirectorRole> directors;       /**< Директор */
+    Crew<VeterinarianRole> vets;        /**< Ветеринары */
+    Crew<CleanerRole> cleaners;         /**< Уборщики */
+    Crew<FeederRole> feeders;           /**< Кормильцы */
+
+public:
+    explicit WorkerRoster(pmr::memory_resource* r) : directors(r), vets(r), cleaners(r), feeders(r) {}
+
+    /**
+     * @brief Вызывает функцию для каждой бригады (тип бригады несет политику роли).
+     * @param f Функция, принимающая Crew<Role>&.
+     */
+    template<typename F>
+    void forEachCrew(F&& f) {
+        f(directors);
+        f(vets);
+        f(cleaners);
+        f(feeders);
+    }
+
+    /**
+     * @brief Вызывает функцию для каждой бригады без изменения.
+     * @param f Функция, принимающая const Crew<Role>&.
+     */
+    template<typename F>
+    void forEachCrew(F&& f) const {
+        f(directors);
+        f(vets);
+        f(cleaners);
+        f(feeders);
+    }
+
+    /**
+     * @brief Получает параметры роли по типу работника.
+     * @param t Тип работника.
+     * @return Параметры роли.
+     */
+    static const RoleInfo& info(WorkerType t) {
+        static constexpr const RoleInfo* roles[] = { &Crew<DirectorRole>::info, &Crew<VeterinarianRole>::info,
+            &Crew<CleanerRole>::info, &Crew<FeederRole>::info };
+        return **find_if(begin(roles), end(roles), [t](const RoleInfo* r) { return r->type == t; });
+    }
+
+    /**
+     * @brief Нанимает работника в бригаду его роли.
+     * @param t Тип работника.
+     * @param worker Работник.
+     */
+    void hire(WorkerType t, Worker worker) {
+        forEachCrew([&](auto& crew) {
+            if (crew.info.type == t) crew.members.push_back(std::move(worker));
+        });
+    }
+
+    /**
+     * @brief Получает количество работников.
+     * @return Количество работников всех ролей.
+     */
+    size_t size() const {
+        size_t total = 0;
+        forEachCrew([&](const auto& crew) { total += crew.members.size(); });
+        return total;
+    }
+
+    /**
+     * @brief Проверяет, есть ли работники.
+     * @return Истина, если работников нет.
+     */
+    bool empty() const { return size() == 0; }
+
+    /**
+     * @brief Получает работника по сквозному номеру.
+     * @param index Номер (0 — директор, далее бригады по порядку ролей).
+     * @return Работник и параметры его роли.
+     */
+    Entry at(size_t index) {
+        Worker* found = nullptr;
+        const RoleInfo* role = nullptr;
+        forEachCrew([&](auto& crew) {
+            if (found) return;
+            if (index < crew.members.size()) {
+                found = &crew.members[index];
+                role = &crew.info;
+            }
+            else index -= crew.members.size();
+        });
+        return { *found, *role };
+    }
+
+    /**
+     * @brief Увольняет работника по сквозному номеру.
+     * @param index Номер работника.
+     */
+    void erase(size_t index) {
+        bool done = false;
+        forEachCrew([&](auto& crew) {
+            if (done) return;
+            if (index < crew.members.size()) {
+                crew.members.erase(crew.members.begin() + index);
+                done = true;
+            }
+            else index -= crew.members.size();
+        });
+    }
+
+    /**
+     * @brief Рассчитывает дневную зарплату всех работников.
+     * @return Сумма зарплат.
+     */
+    int payroll() const {
+        int total = 0;
+        forEachCrew([&](const auto& crew) { total += crew.payroll(); });
+        return total;
+    }
+};
+
+/**
+ * @class DayArena
+ * @brief Линейный (bump) аллокатор для временных данных одного игрового дня.
+ *
+ * Выделение памяти — сдвиг указателя внутри блока, освобождение отдельных объектов не выполняется.
+ * Вся память возвращается разом вызовом reset() в начале следующего дня; блоки при этом сохраняются,
+ * поэтому в установившемся режиме обращений к общему аллокатору нет. Память одного действия внутри дня
+ * возвращается раньше отметкой Scope.
+ */
+class DayArena : public pmr::memory_resource {
+private:
+    struct Block {
+        byte* data;            /**< Начало блока */
+        size_t size;           /**< Размер блока в байтах */
+    };
+
+    pmr::memory_resource* upstream; /**< Источник блоков */
+    vector<Block> blocks;           /**< Выделенные блоки (сохраняются между днями) */
+    size_t current;                 /**< Индекс текущего блока */
+    size_t offset;                  /**< Смещение свободной памяти в текущем блоке */
+    size_t upstreamAllocations;     /**< Количество запросов блоков у источника */
+    uint64_t generation;            /**< Номер дня арены (растет при каждом reset) */
+
+    static constexpr size_t initialBlockSize = 16 * 1024; /**< Размер первого блока */
+
+    /**
+     * @brief Добавляет новый блок не меньше указанного размера.
+     * @param minSize Минимальный размер блока.
+     */
+    void addBlock(size_t minSize) {
+        size_t size = blocks.empty() ? initialBlockSize : blocks.back().size * 2;
+        while (size < minSize) size *= 2;
+        blocks.push_back({ static_cast<byte*>(upstream->allocate(size, alignof(max_align_t))), size });
+        upstreamAllocations++;
+    }
+
+    /**
+     * @brief Освобождает все блоки.
+     */
+    void releaseBlocks() {
+        for (const auto& block : blocks) upstream->deallocate(block.data, block.size, alignof(max_align_t));
+        blocks.clear();
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        while (true) {
+            if (current < blocks.size()) {
+                Block& block = blocks[current];
+                uintptr_t address = reinterpret_cast<uintptr_t>(block.data) + offset;
+                size_t aligned = offset + ((alignment - address % alignment) % alignment);
+                if (aligned <= block.size && bytes <= block.size - aligned) {
+                    offset = aligned + bytes;
+                    return block.data + aligned;
+                }
+                if (current + 1 < blocks.size()) {
+                    current++;
+                    offset = 0;
+                    continue;
+                }
+            }
+            addBlock(bytes + alignment);
+            current = blocks.size() - 1;
+            offset = 0;
+        }
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+    /**
+     * @brief Создает арену.
+     * @param up Источник блоков (по умолчанию new/delete).
+     */
+    explicit DayArena(pmr::memory_resource* up = pmr::new_delete_resource())
+        : upstream(up), current(0), offset(0), upstreamAllocations(0), generation(0) {
+    }
+
+    DayArena(const DayArena&) = delete;
+    DayArena& operator=(const DayArena&) = delete;
+
+    ~DayArena() override { releaseBlocks(); }
+
+    /**
+     * @brief Освобождает всю выделенную за день память.
+     *
+     * Если за день понадобилось несколько блоков, они заменяются одним блоком суммарного размера,
+     * чтобы следующий день уложился в него целиком.
+     */
+    void reset() {
+        if (blocks.size() > 1) {
+            size_t total = 0;
+            for (const auto& block : blocks) total += block.size;
+            releaseBlocks();
+            addBlock(total);
+        }
+        current = 0;
+        offset = 0;
+        generation++;
+    }
+
+    /**
+     * @class Scope
+     * @brief Отметка арены на время одного действия.
+     *
+     * При выходе из области видимости память, выделенная после отметки, снова считается свободной, поэтому
+     * меню, в котором игрок остается весь день, не наращивает арену. Все объекты в этой памяти должны быть
+     * уничтожены раньше отметки. Если арену за это время сбросили (наступил новый день), отметка ничего не делает.
+     */
+    class Scope {
+    public:
+        /**
+         * @brief Запоминает текущее положение арены.
+         * @param a Арена.
+         */
+        explicit Scope(DayArena& a) : arena(a), generation(a.generation), block(a.current), offset(a.offset) {}
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope() {
+            if (arena.generation != generation) return;
+            arena.current = block;
+            arena.offset = offset;
+        }
+
+    private:
+        DayArena& arena;       /**< Арена */
+        uint64_t generation;   /**< Номер дня арены при отметке */
+        size_t block;          /**< Текущий блок при отметке */
+        size_t offset;         /**< Смещение при отметке */
+    };
+
+    /**
+     * @brief Получает количество запросов блоков у источника за время жизни арены.
+     * @return Количество выделений у источника.
+     */
+    size_t getUpstreamAllocations() const { return upstreamAllocations; }
+};
+
+/**
+ * @class AnimalKernels
+ * @brief Пакетные вычисления дня над столбцами данных животных.
+ *
+ * Животные хранятся записями, поэтому nextDay собирает нужные поля (идентификаторы, возраст, болезнь)
+ * в столбцы в арене дня и обрабатывает их пакетами. Вариант на AVX2 выбирается при запуске, если его
+ * поддерживает процессор, иначе работает скалярный; результаты обоих совпадают побитно с Rng::keyedPercent.
+ * Маски результатов упакованы по биту на животное: бит i & 7 байта i >> 3.
+ */
+class AnimalKernels {
+public:
+    /**
+     * @brief Вычисляет броски от 0 до 99 для пакета объектов.
+     * @param prefix Префикс ключа (Rng::keyedPrefix).
+     * @param ids Идентификаторы объектов.
+     * @param count Количество объектов.
+     * @param rolls Броски (заполняется, count элементов).
+     */
+    static void rollPercents(uint64_t prefix, const uint32_t* ids, size_t count, uint8_t* rolls) {
+        implementation().rollPercents(prefix, ids, count, rolls);
+    }
+
+    /**
+     * @brief Увеличивает возраст животных и отмечает смерти от старости и новые болезни.
+     *
+     * Животное умирает, если после увеличения возраст больше oldAgeDays и бросок старения меньше возраста;
+     * заболевает, если оно здорово и бросок болезни меньше sicknessPercent.
+     * @param ages Возраст в днях (увеличивается на месте, не выше 65535).
+     * @param agingRolls Броски старения.
+     * @param sick Признак болезни (0 или 1).
+     * @param sicknessRolls Броски болезни.
+     * @param count Количество животных.
+     * @param oldAgeDays Возраст, после которого возможна смерть от старости.
+     * @param sicknessPercent Вероятность заболеть в процентах.
+     * @param dies Маска смертей (заполняется, (count + 7) / 8 байт).
+     * @param fallsSick Маска новых болезней (заполняется, (count + 7) / 8 байт).
+     */
+    static void markDay(int32_t* ages, const uint8_t* agingRolls, const uint8_t* sick, const uint8_t* sicknessRolls,
+        size_t count, int oldAgeDays, int sicknessPercent, uint8_t* dies, uint8_t* fallsSick) {
+        implementation().markDay(ages, agingRolls, sick, sicknessRolls, count, oldAgeDays, sicknessPercent, dies, fallsSick);
+    }
+
+    /**
+     * @brief Проверяет бит маски.
+     * @param mask Маска.
+     * @param index Номер животного.
+     * @return Истина, если бит установлен.
+     */
+    static bool test(const uint8_t* mask, size_t index) { return (mask[index >> 3] >> (index & 7)) & 1; }
+
+    /**
+     * @brief Получает название выбранного варианта.
+     * @return "avx2" или "scalar".
+     */
+    static const char* name() { return implementation().name; }
+
+private:
+    struct Implementation {
+        void (*rollPercents)(uint64_t, const uint32_t*, size_t, uint8_t*);
+        void (*markDay)(int32_t*, const uint8_t*, const uint8_t*, const uint8_t*, size_t, int, int, uint8_t*, uint8_t*);
+        const char* name;
+    };
+
+    static void rollPercentsScalar(uint64_t prefix, const uint32_t* ids, size_t count, uint8_t* rolls) {
+        for (size_t i = 0; i < count; ++i) rolls[i] = static_cast<uint8_t>(Rng::percent(Rng::keyedById(prefix, ids[i])));
+    }
+
+    static void markDayScalar(int32_t* ages, const uint8_t* agingRolls, const uint8_t* sick, const uint8_t* sicknessRolls,
+        size_t count, int oldAgeDays, int sicknessPercent, uint8_t* dies, uint8_t* fallsSick) {
+        fill(dies, dies + (count + 7) / 8, 0);
+        fill(fallsSick, fallsSick + (count + 7) / 8, 0);
+        for (size_t i = 0; i < count; ++i) {
+            ages[i] = min(ages[i] + 1, 65535);
+            uint8_t bit = static_cast<uint8_t>(1u << (i & 7));
+            if (ages[i] > oldAgeDays && agingRolls[i] < ages[i]) dies[i >> 3] |= bit;
+            if (!sick[i] && sicknessRolls[i] < sicknessPercent) fallsSick[i >> 3] |= bit;
+        }
+    }
+
+#if defined(__x86_64__) || defined(_M_X64)
+    /**
+     * @brief Умножает 64-битные элементы на константу по модулю 2^64 (в AVX2 нет такой инструкции).
+     */
+    ZOO_TARGET_AVX2 static __m256i multiply64(__m256i a, uint64_t c) {
+        __m256i low = _mm256_set1_epi64x(static_cast<int64_t>(c & 0xFFFFFFFFu));
+        __m256i high = _mm256_set1_epi64x(static_cast<int64_t>(c >> 32));
+        __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), low), _mm256_mul_epu32(a, high));
+        return _mm256_add_epi64(_mm256_mul_epu32(a, low), _mm256_slli_epi64(cross, 32));
+    }
+
+    /**
+     * @brief Броски четырех объектов: splitmix64 по 64-битным элементам, результат в младших 32 битах.
+     */
+    ZOO_TARGET_AVX2 static __m256i percent4(__m256i prefix, __m128i ids) {
+        __m256i z = _mm256_add_epi64(_mm256_xor_si256(prefix, _mm256_cvtepu32_epi64(ids)),
+            _mm256_set1_epi64x(static_cast<int64_t>(Rng::mixIncrement)));
+        z = multiply64(_mm256_xor_si256(z, _mm256_srli_epi64(z, 30)), Rng::mixMultiplier1);
+        z = multiply64(_mm256_xor_si256(z, _mm256_srli_epi64(z, 27)), Rng::mixMultiplier2);
+        z = _mm256_xor_si256(z, _mm256_srli_epi64(z, 31));
+        return _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(z, 32), _mm256_set1_epi64x(100)), 32);
+    }
+
+    ZOO_TARGET_AVX2 static void rollPercentsAvx2(uint64_t prefix, const uint32_t* ids, size_t count, uint8_t* rolls) {
+        const __m256i keys = _mm256_set1_epi64x(static_cast<int64_t>(prefix));
+        // Из четырех 64-битных элементов каждого вектора берутся младшие половины: восемь бросков подряд.
+        const __m256i gather = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i lowHalf = _mm256_permutevar8x32_epi32(
+                percent4(keys, _mm_loadu_si128(reinterpret_cast<const __m128i*>(ids + i))), gather);
+            __m256i highHalf = _mm256_permutevar8x32_epi32(
+                percent4(keys, _mm_loadu_si128(reinterpret_cast<const __m128i*>(ids + i + 4))), gather);
+            __m128i packed16 = _mm_packus_epi32(_mm256_castsi256_si128(lowHalf), _mm256_castsi256_si128(highHalf));
+            __m128i packed8 = _mm_packus_epi16(packed16, _mm_setzero_si128());
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(rolls + i), packed8);
+        }
+        rollPercentsScalar(prefix, ids + i, count - i, rolls + i);
+    }
+
+    ZOO_TARGET_AVX2 static void markDayAvx2(int32_t* ages, const uint8_t* agingRolls, const uint8_t* sick,
+        const uint8_t* sicknessRolls, size_t count, int oldAgeDays, int sicknessPercent, uint8_t* dies, uint8_t* fallsSick) {
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i maxAge = _mm256_set1_epi32(65535);
+        const __m256i oldAge = _mm256_set1_epi32(oldAgeDays);
+        const __m256i sickness = _mm256_set1_epi32(sicknessPercent);
+        const __m256i zero = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i age = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ages + i));
+            age = _mm256_min_epi32(_mm256_add_epi32(age, one), maxAge);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(ages + i), age);
+            __m256i aging = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(agingRolls + i)));
+            __m256i dead = _mm256_and_si256(_mm256_cmpgt_epi32(age, oldAge), _mm256_cmpgt_epi32(age, aging));
+            __m256i healthy = _mm256_cmpeq_epi32(_mm256_cvtepu8_epi32(
+                _mm_loadl_epi64(reinterpret_cast<const __m128i*>(sick + i))), zero);
+            __m256i roll = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(sicknessRolls + i)));
+            __m256i falls = _mm256_and_si256(healthy, _mm256_cmpgt_epi32(sickness, roll));
+            dies[i >> 3] = static_cast<uint8_t>(_mm256_movemask_ps(_mm256_castsi256_ps(dead)));
+            fallsSick[i >> 3] = static_cast<uint8_t>(_mm256_movemask_ps(_mm256_castsi256_ps(falls)));
+        }
+        if (i < count) {
+            // Хвост обрабатывается скалярно во временные маски, чтобы не затереть уже записанные байты.
+            uint8_t tailDies = 0, tailFalls = 0;
+            markDayScalar(ages + i, agingRolls + i, sick + i, sicknessRolls + i, count - i, oldAgeDays, sicknessPercent,
+                &tailDies, &tailFalls);
+            dies[i >> 3] = tailDies;
+            fallsSick[i >> 3] = tailFalls;
+        }
+    }
+
+public:
+    /**
+     * @brief Проверяет поддержку AVX2 процессором и операционной системой.
+     * @return Истина, если можно использовать инструкции AVX2.
+     */
+    static bool hasAvx2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return osSavesYmm && (info[1] & (1 << 5));
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+private:
+#endif
+
+    /**
+     * @brief Выбирает вариант при первом обращении.
+     */
+    static const Implementation& implementation() {
+        static const Implementation chosen = [] {
+#if defined(__x86_64__) || defined(_M_X64)
+            if (hasAvx2()) return Implementation{ &rollPercentsAvx2, &markDayAvx2, "avx2" };
+#endif
+            return Implementation{ &rollPercentsScalar, &markDayScalar, "scalar" };
+        }();
+        return chosen;
+    }
+};
+
+/**
+ * @class RngLanes
+ * @brief Пакетный генератор: восемь чередующихся потоков xoshiro256**.
+ *
+ * Значение i пакета берется из потока i % 8 на шаге i / 8, и каждый вызов продвигает все потоки на
+ * целое число шагов. Поэтому последовательность не зависит от ширины векторов: вариант на AVX2 считает
+ * по четыре потока за инструкцию, скалярный — по одному, а результат одинаков. Это же верно для
+ * производных заполнений (равномерные целые, маски Бернулли): они только отображают сырые значения.
+ *
+ * В тике зоопарка генератор дает броски голода. Броски старения и болезни остаются на ключевом пути
+ * (AnimalKernels::rollPercents): они зависят от зерна, дня и идентификатора животного, а не от порядка
+ * вызовов, и перевод их на потоки изменил бы результаты игр с заданным зерном.
+ */
+class RngLanes {
+public:
+    static constexpr size_t lanes = 8;         /**< Количество потоков */
+    static constexpr uint64_t laneStream = 8;  /**< Поток ключей для инициализации */
+
+    /**
+     * @brief Создает генератор.
+     * @param seed Зерно.
+     */
+    explicit RngLanes(uint64_t seed = 0) { reseed(seed); }
+
+    /**
+     * @brief Переинициализирует генератор.
+     * @param seed Зерно.
+     */
+    void reseed(uint64_t seed) {
+        for (size_t word = 0; word < 4; ++word) {
+            for (size_t lane = 0; lane < lanes; ++lane) state[word][lane] = Rng::keyed(seed, lane, word, laneStream);
+        }
+    }
+
+    /**
+     * @brief Заполняет буфер 64-битными значениями.
+     * @param out Буфер.
+     * @param count Количество значений.
+     */
+    void fill(uint64_t* out, size_t count) {
+        size_t full = count / lanes;
+        if (full > 0) implementation()(state, out, full);
+        if (size_t rest = count % lanes) {
+            uint64_t block[lanes];
+            implementation()(state, block, 1);
+            copy(block, block + rest, out + full * lanes);
+        }
+    }
+
+    /**
+     * @brief Заполняет буфер случайными целыми числами из диапазона (отображение как в Rng::uniform).
+     * @param min Минимальное значение (включительно).
+     * @param max Максимальное значение (включительно).
+     * @param out Буфер.
+     * @param count Количество значений.
+     */
+    void fillUniform(int min, int max, int32_t* out, size_t count) {
+        uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min + 1);
+        uint64_t raw[chunk];
+        for (size_t i = 0; i < count; i += chunk) {
+            size_t n = std::min(chunk, count - i);
+            fill(raw, n);
+            for (size_t k = 0; k < n; ++k) out[i + k] = static_cast<int32_t>(min + static_cast<int64_t>(((raw[k] >> 32) * range) >> 32));
+        }
+    }
+
+    /**
+     * @brief Заполняет маску испытаний Бернулли: бит i & 7 байта i >> 3 установлен с вероятностью p.
+     * @param p Вероятность успеха.
+     * @param mask Маска (заполняется, (count + 7) / 8 байт).
+     * @param count Количество испытаний.
+     */
+    void fillBernoulli(double p, uint8_t* mask, size_t count) {
+        uint64_t threshold = p <= 0 ? 0 : p >= 1 ? (1ull << 32) : static_cast<uint64_t>(p * 4294967296.0);
+        uint64_t raw[chunk];
+        for (size_t i = 0; i < count; i += chunk) {
+            size_t n = std::min(chunk, count - i);
+            fill(raw, n);
+            for (size_t k = 0; k < n; k += 8) {
+                uint8_t bits = 0;
+                for (size_t b = 0; b < 8 && k + b < n; ++b) {
+                    bits |= static_cast<uint8_t>(((raw[k + b] >> 32) < threshold) << b);
+                }
+                mask[(i + k) >> 3] = bits;
+            }
+        }
+    }
+
+private:
+    using State = uint64_t[4][lanes];
+    using Steps = void (*)(State&, uint64_t*, size_t);
+
+    static constexpr size_t chunk = 256;  /**< Размер промежуточного буфера (кратен lanes) */
+
+    alignas(32) State state; /**< Состояние потоков: слово × поток */
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    static void stepsScalar(State& s, uint64_t* out, size_t steps) {
+        for (size_t step = 0; step < steps; ++step) {
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                out[step * lanes + lane] = rotl(s[1][lane] * 5, 7) * 9;
+                uint64_t t = s[1][lane] << 17;
+                s[2][lane] ^= s[0][lane];
+                s[3][lane] ^= s[1][lane];
+                s[1][lane] ^= s[2][lane];
+                s[0][lane] ^= s[3][lane];
+                s[2][lane] ^= t;
+                s[3][lane] = rotl(s[3][lane], 45);
+            }
+        }
+    }
+
+#if defined(__x86_64__) || defined(_M_X64)
+    ZOO_TARGET_AVX2 static __m256i rotl4(__m256i x, int k) {
+        return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+    }
+
+    /**
+     * @brief Шаг четырех потоков; умножения на 5 и 9 заменены сдвигами со сложением.
+     */
+    ZOO_TARGET_AVX2 static __m256i step4(__m256i& s0, __m256i& s1, __m256i& s2, __m256i& s3) {
+        __m256i times5 = _mm256_add_epi64(_mm256_slli_epi64(s1, 2), s1);
+        __m256i rotated = rotl4(times5, 7);
+        __m256i result = _mm256_add_epi64(_mm256_slli_epi64(rotated, 3), rotated);
+        __m256i t = _mm256_slli_epi64(s1, 17);
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = rotl4(s3, 45);
+        return result;
+    }
+
+    ZOO_TARGET_AVX2 static void stepsAvx2(State& s, uint64_t* out, size_t steps) {
+        __m256i v[2][4];
+        for (int half = 0; half < 2; ++half) {
+            for (int word = 0; word < 4; ++word) {
+                v[half][word] = _mm256_load_si256(reinterpret_cast<const __m256i*>(&s[word][half * 4]));
+            }
+        }
+        for (size_t step = 0; step < steps; ++step) {
+            for (int half = 0; half < 2; ++half) {
+                __m256i result = step4(v[half][0], v[half][1], v[half][2], v[half][3]);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + step * lanes + half * 4), result);
+            }
+        }
+        for (int half = 0; half < 2; ++half) {
+            for (int word = 0; word < 4; ++word) {
+                _mm256_store_si256(reinterpret_cast<__m256i*>(&s[word][half * 4]), v[half][word]);
+            }
+        }
+    }
+#endif
+
+    /**
+     * @brief Выбирает вариант при первом обращении.
+     */
+    static Steps implementation() {
+        static const Steps chosen = []() -> Steps {
+#if defined(__x86_64__) || defined(_M_X64)
+            if (AnimalKernels::hasAvx2()) return &stepsAvx2;
+#endif
+            return &stepsScalar;
+        }();
+        return chosen;
+    }
+};
+
+/**
+ * @class DayForecast
+ * @brief Предварительный расчет следующего дня в фоновом потоке.
+ *
+ * Пока игрок находится в меню, фоновый поток готовит то, что не зависит от его действий: состав рынка
+ * следующего дня и броски старения и болезни для животных, живших в зоопарке на момент запуска.
+ * Все броски определяются зерном, днем и идентификатором животного, поэтому совпадают с вычисленными
+ * на месте: если расчет не успел, устарел или не охватывает животное, nextDay досчитывает недостающее
+ * сам, и результат дня от этого не меняется. Поток работает только со своими копиями данных.
+ *
+ * Поток создается при первом запуске и живет, пока жив расчет: каждый день он получает новое задание
+ * через условную переменную. Снимок идентификаторов заполняет вызывающий поток, пока фоновый свободен,
+ * поэтому снимок может лежать в несинхронизированном пуле зоопарка; буферы сохраняют емкость между днями.
+ */
+class DayForecast {
+public:
+    static constexpr uint64_t agingStream = 1;    /**< Поток бросков старения */
+    static constexpr uint64_t sicknessStream = 2; /**< Поток бросков болезни */
+    static constexpr uint64_t marketStream = 3;   /**< Поток состава рынка */
+
+    /**
+     * @struct Rolls
+     * @brief Броски одного животного на день.
+     */
+    struct Rolls {
+        uint32_t animalId;     /**< Идентификатор животного */
+        uint8_t aging;         /**< Бросок смерти от старости (0-99) */
+        uint8_t sickness;      /**< Бросок болезни (0-99) */
+    };
+
+    /**
+     * @brief Вычисляет броски животного на день.
+     * @param seed Зерно зоопарка.
+     * @param day Игровой день.
+     * @param animalId Идентификатор животного.
+     * @return Броски старения и болезни.
+     */
+    static Rolls rollAnimal(uint64_t seed, int day, uint32_t animalId) {
+        return { animalId, static_cast<uint8_t>(Rng::keyedPercent(seed, day, animalId, agingStream)),
+            static_cast<uint8_t>(Rng::keyedPercent(seed, day, animalId, sicknessStream)) };
+    }
+
+    /**
+     * @brief Выбирает состав рынка: индексы каталога и пол каждого животного.
+     * @param r Генератор.
+     * @param catalogSize Размер каталога.
+     * @param order Выбранные индексы каталога (заполняется).
+     * @param genders Пол выбранных животных (заполняется).
+     */
+    static void planMarket(Rng& r, size_t catalogSize, pmr::vector<uint32_t>& order, pmr::vector<Gender>& genders) {
+        order.resize(catalogSize);
+        iota(order.begin(), order.end(), 0u);
+        std::shuffle(order.begin(), order.end(), r);
+        order.resize(min<size_t>(10, catalogSize));
+        genders.clear();
+        for (size_t i = 0; i < order.size(); ++i) genders.push_back(r.uniform(0, 1) ? Gender::MALE : Gender::FEMALE);
+    }
+
+private:
+    thread worker;                     /**< Фоновый поток расчета (создается при первом запуске) */
+    mutex lock;                        /**< Защита состояния задания */
+    condition_variable wake;           /**< Сигнал потоку: есть задание или пора завершаться */
+    condition_variable idle;           /**< Сигнал вызывающему: задание выполнено */
+    bool requested;                    /**< Задание ждет потока */
+    bool busy;                         /**< Поток выполняет задание */
+    bool stopping;                     /**< Поток должен завершиться */
+    atomic<bool> cancelled;            /**< Запрос на досрочное завершение */
+    bool complete;                     /**< Расчет завершен (читается после ожидания idle) */
+    uint64_t seed;                     /**< Зерно зоопарка */
+    int day;                           /**< День, для которого ведется расчет */
+    size_t catalogSize;                /**< Размер каталога рынка */
+    pmr::vector<uint32_t> animalIds;   /**< Снимок идентификаторов животных */
+    pmr::vector<Rolls> rolls;          /**< Броски, упорядоченные по идентификатору */
+    pmr::vector<uint32_t> marketOrder; /**< Индексы каталога для рынка */
+    pmr::vector<Gender> marketGenders; /**< Пол животных рынка */
+
+    /**
+     * @brief Тело фонового потока.
+     */
+    void compute() {
+        uint64_t agingPrefix = Rng::keyedPrefix(seed, day, agingStream);
+        uint64_t sicknessPrefix = Rng::keyedPrefix(seed, day, sicknessStream);
+        uint8_t aging[4096], sickness[4096];
+        rolls.reserve(animalIds.size());
+        for (size_t i = 0; i < animalIds.size(); i += 4096) {
+            if (cancelled.load(memory_order_relaxed)) return;
+            size_t count = min<size_t>(4096, animalIds.size() - i);
+            AnimalKernels::rollPercents(agingPrefix, animalIds.data() + i, count, aging);
+            AnimalKernels::rollPercents(sicknessPrefix, animalIds.data() + i, count, sickness);
+            for (size_t k = 0; k < count; ++k) rolls.push_back({ animalIds[i + k], aging[k], sickness[k] });
+        }
+        sort(rolls.begin(), rolls.end(), [](const Rolls& a, const Rolls& b) { return a.animalId < b.animalId; });
+        Rng marketRng(Rng::keyed(seed, day, 0, marketStream));
+        planMarket(marketRng, catalogSize, marketOrder, marketGenders);
+        complete = true;
+    }
+
+    /**
+     * @brief Цикл фонового потока: ждет задание, выполняет его и сообщает об окончании.
+     */
+    void serve() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [this] { return requested || stopping; });
+            if (stopping) return;
+            requested = false;
+            busy = true;
+            guard.unlock();
+            compute();
+            guard.lock();
+            busy = false;
+            idle.notify_all();
+        }
+    }
+
+    /**
+     * @brief Дожидается, пока у потока не останется заданий.
+     */
+    void waitIdle() {
+        unique_lock<mutex> guard(lock);
+        idle.wait(guard, [this] { return !requested && !busy; });
+    }
+
+public:
+    /**
+     * @brief Создает расчет.
+     * @param snapshot Ресурс памяти снимка идентификаторов (используется только вызывающим потоком).
+     */
+    explicit DayForecast(pmr::memory_resource* snapshot = pmr::get_default_resource())
+        : requested(false), busy(false), stopping(false), cancelled(false), complete(false), seed(0), day(-1), catalogSize(0),
+        animalIds(snapshot) {
+    }
+
+    DayForecast(const DayForecast&) = delete;
+    DayForecast& operator=(const DayForecast&) = delete;
+
+    ~DayForecast() {
+        discard();
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+    /**
+     * @brief Запускает расчет дня в фоновом потоке (предыдущий расчет отбрасывается).
+     * @tparam Fill Функция, заполняющая снимок: void(pmr::vector<uint32_t>&).
+     * @param s Зерно зоопарка.
+     * @param d День, который будет рассчитан.
+     * @param catSize Размер каталога рынка.
+     * @param fill Заполняет пустой снимок идентификаторов животных (вызывается, пока поток свободен).
+     */
+    template<class Fill>
+    void start(uint64_t s, int d, size_t catSize, Fill&& fill) {
+        discard();
+        seed = s;
+        day = d;
+        catalogSize = catSize;
+        animalIds.clear();
+        fill(animalIds);
+        cancelled = false;
+        {
+            lock_guard<mutex> guard(lock);
+            requested = true;
+        }
+        if (!worker.joinable()) worker = thread(&DayForecast::serve, this);
+        else wake.notify_one();
+    }
+
+    /**
+     * @brief Останавливает расчет и отбрасывает его результаты.
+     */
+    void discard() {
+        cancelled = true;
+        waitIdle();
+        complete = false;
+        day = -1;
+        rolls.clear();
+        marketOrder.clear();
+        marketGenders.clear();
+    }
+
+    /**
+     * @brief Дожидается окончания расчета.
+     * @param d День, для которого нужны результаты.
+     * @return Истина, если расчет завершен и относится к этому дню.
+     */
+    bool finish(int d) {
+        waitIdle();
+        return complete && day == d;
+    }
+
+    /**
+     * @brief Получает бросок животного из расчета.
+     * @param animalId Идентификатор животного.
+     * @return Указатель на броски или nullptr, если животного не было в снимке.
+     */
+    const Rolls* find(uint32_t animalId) const {
+        auto it = lower_bound(rolls.begin(), rolls.end(), animalId,
+            [](const Rolls& r, uint32_t id) { return r.animalId < id; });
+        return it != rolls.end() && it->animalId == animalId ? &*it : nullptr;
+    }
+
+    /**
+     * @brief Получает индексы каталога для рынка.
+     * @return Ссылка на вектор индексов.
+     */
+    const pmr::vector<uint32_t>& getMarketOrder() const { return marketOrder; }
+
+    /**
+     * @brief Получает пол животных рынка.
+     * @return Ссылка на вектор полов.
+     */
+    const pmr::vector<Gender>& getMarketGenders() const { return marketGenders; }
+};
+
+/**
+ * @class TaskPool
+ * @brief Пул потоков с перехватом задач (work stealing).
+ *
+ * У каждого рабочего потока своя очередь: владелец берет задачи с ее конца (последние созданные,
+ * их данные еще в кэше), а свободные потоки забирают задачи с начала чужих очередей. Задачи,
+ * созданные внутри задачи, попадают в очередь текущего потока; задачи из других потоков — в общую
+ * очередь. Ожидающий группу поток не простаивает, а выполняет чужие задачи (см. TaskGroup::wait),
+ * поэтому вложенный параллелизм (много зоопарков × много вольеров) не требует лишних потоков.
+ */
+class TaskPool {
+public:
+    using Task = function<void()>; /**< Задача пула */
+
+private:
+    struct Queue {
+        mutex lock;            /**< Защита очереди */
+        deque<Task> tasks;     /**< Задачи */
+    };
+
+    vector<unique_ptr<Queue>> queues; /**< Очереди потоков; последняя — общая */
+    vector<thread> threads;           /**< Рабочие потоки */
+    mutex sleepLock;                  /**< Защита ожидания работы */
+    condition_variable wake;          /**< Сигнал о новой задаче или остановке */
+    atomic<size_t> queued;            /**< Задач в очередях */
+    bool stopping;                    /**< Пул останавливается */
+
+    static thread_local TaskPool* currentPool; /**< Пул текущего рабочего потока */
+    static thread_local size_t currentIndex;   /**< Индекс текущего рабочего потока */
+
+    /**
+     * @brief Забирает задачу: сначала с конца своей очереди, затем с начала чужих.
+     * @param home Индекс очереди вызывающего потока.
+     * @param task Полученная задача.
+     * @return Истина, если задача найдена.
+     */
+    bool take(size_t home, Task& task) {
+        {
+            Queue& own = *queues[home];
+            lock_guard<mutex> guard(own.lock);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                queued--;
+                return true;
+            }
+        }
+        for (size_t k = 1; k < queues.size(); ++k) {
+            Queue& victim = *queues[(home + k) % queues.size()];
+            lock_guard<mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                queued--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Цикл рабочего потока.
+     * @param index Индекс потока.
+     */
+    void workerLoop(size_t index) {
+        currentPool = this;
+        currentIndex = index;
+        Task task;
+        while (true) {
+            if (take(index, task)) {
+                task();
+                task = nullptr;
+                continue;
+            }
+            unique_lock<mutex> guard(sleepLock);
+            wake.wait(guard, [this] { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() == 0) return;
+        }
+    }
+
+    /**
+     * @brief Получает индекс очереди вызывающего потока.
+     * @return Индекс своей очереди для рабочего потока или общей очереди для остальных.
+     */
+    size_t homeQueue() const { return currentPool == this ? currentIndex : queues.size() - 1; }
+
+public:
+    /**
+     * @brief Создает пул.
+     * @param threadCount Количество рабочих потоков (0 — по числу аппаратных потоков).
+     */
+    explicit TaskPool(size_t threadCount = 0) : queued(0), stopping(false) {
+        if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+        for (size_t i = 0; i <= threadCount; ++i) queues.push_back(make_unique<Queue>());
+        for (size_t i = 0; i < threadCount; ++i) threads.emplace_back(&TaskPool::workerLoop, this, i);
+    }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    ~TaskPool() {
+        {
+            lock_guard<mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    /**
+     * @brief Ставит задачу в очередь.
+     * @param task Задача.
+     */
+    void submit(Task task) {
+        Queue& queue = *queues[homeQueue()];
+        {
+            lock_guard<mutex> guard(queue.lock);
+            queue.tasks.push_back(std::move(task));
+        }
+        queued++;
+        { lock_guard<mutex> guard(sleepLock); }
+        wake.notify_one();
+    }
+
+    /**
+     * @brief Выполняет одну задачу из очередей в вызывающем потоке.
+     * @return Истина, если задача была выполнена.
+     */
+    bool runPending() {
+        Task task;
+        if (!take(homeQueue(), task)) return false;
+        task();
+        return true;
+    }
+
+    /**
+     * @brief Получает количество рабочих потоков.
+     * @return Количество потоков.
+     */
+    size_t size() const { return threads.size(); }
+
+    /**
+     * @brief Получает общий пул для всех параллельных частей программы.
+     * @return Пул с потоками по числу аппаратных потоков.
+     */
+    static TaskPool& shared() {
+        static TaskPool pool;
+        return pool;
+    }
+};
+
+thread_local TaskPool* TaskPool::currentPool = nullptr;
+thread_local size_t TaskPool::currentIndex = 0;
+
+/**
+ * @class TaskGroup
+ * @brief Группа задач пула с ожиданием завершения.
+ *
+ * Каждая задача получает собственный генератор, зерно которого определяется зерном группы и
+ * порядковым номером задачи, а не потоком исполнения, поэтому результат параллельного прогона
+ * не зависит от числа потоков и порядка перехвата. Первое исключение задачи повторно
+ * выбрасывается из wait().
+ */
+class TaskGroup {
+private:
+    static constexpr uint64_t taskStream = 4; /**< Поток генераторов задач */
+
+    TaskPool& pool;          /**< Пул исполнения */
+    uint64_t seed;           /**< Зерно группы */
+    uint64_t submitted;      /**< Количество созданных задач */
+    atomic<size_t> pending;  /**< Незавершенные задачи */
+    mutex errorLock;         /**< Защита первого исключения */
+    exception_ptr error;     /**< Первое исключение задачи */
+
+public:
+    /**
+     * @brief Создает группу.
+     * @param p Пул исполнения.
+     * @param s Зерно генераторов задач.
+     */
+    explicit TaskGroup(TaskPool& p = TaskPool::shared(), uint64_t s = 0) : pool(p), seed(s), submitted(0), pending(0) {}
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup() {
+        while (pending.load(memory_order_acquire) > 0) {
+            if (!pool.runPending()) this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Запускает задачу.
+     * @param f Функция без аргументов или принимающая Rng& — генератор, привязанный к номеру задачи.
+     */
+    template<class F>
+    void run(F f) {
+        uint64_t index = submitted++;
+        pending.fetch_add(1, memory_order_relaxed);
+        pool.submit([this, f = std::move(f), index]() mutable {
+            try {
+                if constexpr (is_invocable_v<F&, Rng&>) {
+                    Rng rng(Rng::keyed(seed, index, 0, taskStream));
+                    f(rng);
+                }
+                else f();
+            }
+            catch (...) {
+                lock_guard<mutex> guard(errorLock);
+                if (!error) error = current_exception();
+            }
+            pending.fetch_sub(1, memory_order_acq_rel);
+        });
+    }
+
+    /**
+     * @brief Дожидается завершения всех задач группы, выполняя задачи пула в ожидании.
+     */
+    void wait() {
+        while (pending.load(memory_order_acquire) > 0) {
+            if (!pool.runPending()) this_thread::yield();
+        }
+        if (error) {
+            exception_ptr e = error;
+            error = nullptr;
+            rethrow_exception(e);
+        }
+    }
+};
+
+/**
+ * @enum TelemetryKind
+ * @brief Определяет виды событий телеметрии.
+ */
+enum class TelemetryKind : uint16_t {
+    DEATH_OLD_AGE,  /**< Смерть от старости (объект — животное или вид стада, значение — число погибших) */
+    DEATH_HUNGER,   /**< Смерть от голода (объект — животное или вид стада, значение — число погибших) */
+    TREATMENT,      /**< Лечение (объект — ветеринар, значение — число вылеченных) */
+    INCOME,         /**< Доход от посетителей за день */
+    PHASE_TIME      /**< Длительность фазы дня в наносекундах (объект — номер фазы) */
+};
+
+/**
+ * @struct TelemetryEvent
+ * @brief Запись события телеметрии фиксированного размера.
+ */
+struct TelemetryEvent {
+    double value;              /**< Значение события */
+    uint32_t source;           /**< Источник (номер зоопарка или прогона) */
+    int32_t day;               /**< Игровой день */
+    uint32_t subject;          /**< Объект события */
+    TelemetryKind kind;        /**< Вид события */
+};
+
+/**
+ * @class SpscRing
+ * @brief Кольцевой буфер без блокировок для одного производителя и одного потребителя.
+ *
+ * Позиции записи и чтения — атомарные счетчики в разных строках кэша. Каждая сторона держит
+ * копию позиции другой стороны и перечитывает ее только при кажущемся переполнении или опустошении,
+ * поэтому в установившемся режиме стороны не трогают общие строки кэша на каждой операции.
+ * @tparam T Тип записи (копируемый тривиально).
+ * @tparam Capacity Вместимость (степень двойки).
+ */
+template<class T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Вместимость кольцевого буфера должна быть степенью двойки");
+
+private:
+    alignas(64) atomic<size_t> tail;  /**< Позиция записи (производитель) */
+    size_t cachedHead;                /**< Копия позиции чтения у производителя */
+    alignas(64) atomic<size_t> head;  /**< Позиция чтения (потребитель) */
+    size_t cachedTail;                /**< Копия позиции записи у потребителя */
+    alignas(64) T slots[Capacity];    /**< Записи */
+
+public:
+    SpscRing() : tail(0), cachedHead(0), head(0), cachedTail(0) {}
+
+    /**
+     * @brief Добавляет запись (вызывается только производителем).
+     * @param value Запись.
+     * @return Ложь, если буфер полон.
+     */
+    bool tryPush(const T& value) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - cachedHead == Capacity) {
+            cachedHead = head.load(memory_order_acquire);
+            if (t - cachedHead == Capacity) return false;
+        }
+        slots[t & (Capacity - 1)] = value;
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Извлекает запись (вызывается только потребителем).
+     * @param value Извлеченная запись.
+     * @return Ложь, если буфер пуст.
+     */
+    bool tryPop(T& value) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(memory_order_acquire);
+            if (h == cachedTail) return false;
+        }
+        value = slots[h & (Capacity - 1)];
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+};
+
+/**
+ * @class TelemetryWriter
+ * @brief Фоновая запись телеметрии.
+ *
+ * Каждый поток симуляции пишет события в собственный кольцевой буфер (см. channel()), не ожидая
+ * ни блокировок, ни ввода-вывода. Фоновый поток вычитывает буферы и пишет события в поток вывода
+ * в формате CSV. Если писатель не успевает и буфер полон, событие отбрасывается и учитывается
+ * в счетчике потерь — симуляция не замедляется.
+ */
+class TelemetryWriter {
+public:
+    /**
+     * @struct Channel
+     * @brief Буфер событий одного потока симуляции.
+     */
+    struct Channel {
+        SpscRing<TelemetryEvent, 4096> ring; /**< События */
+        atomic<uint64_t> dropped{ 0 };       /**< Отброшенные события */
+
+        /**
+         * @brief Отправляет событие.
+         * @param event Событие.
+         */
+        void push(const TelemetryEvent& event) {
+            if (!ring.tryPush(event)) dropped.fetch_add(1, memory_order_relaxed);
+        }
+    };
+
+private:
+    ostream& out;                          /**< Поток вывода */
+    uint64_t serial;                       /**< Номер писателя (для привязки буферов потоков) */
+    mutex channelsLock;                    /**< Защита списка буферов */
+    vector<unique_ptr<Channel>> channels;  /**< Буферы потоков */
+    atomic<bool> stopping;                 /**< Писатель останавливается */
+    atomic<uint64_t> written;              /**< Записано событий */
+    thread worker;                         /**< Фоновый поток записи */
+
+    /**
+     * @brief Получает имя вида события.
+     * @param kind Вид события.
+     * @return Имя для CSV.
+     */
+    static const char* kindName(TelemetryKind kind) {
+        switch (kind) {
+        case TelemetryKind::DEATH_OLD_AGE: return "death_old_age";
+        case TelemetryKind::DEATH_HUNGER: return "death_hunger";
+        case TelemetryKind::TREATMENT: return "treatment";
+        case TelemetryKind::INCOME: return "income";
+        case TelemetryKind::PHASE_TIME: return "phase_time";
+        }
+        return "unknown";
+    }
+
+    /**
+     * @brief Вычитывает все буферы.
+     * @return Количество записанных событий.
+     */
+    size_t drain() {
+        vector<Channel*> snapshot;
+        {
+            lock_guard<mutex> guard(channelsLock);
+            for (auto& c : channels) snapshot.push_back(c.get());
+        }
+        size_t count = 0;
+        TelemetryEvent event;
+        for (Channel* c : snapshot) {
+            while (c->ring.tryPop(event)) {
+                out << event.source << ',' << event.day << ',' << kindName(event.kind) << ','
+                    << event.subject << ',' << event.value << '\n';
+                count++;
+            }
+        }
+        written += count;
+        return count;
+    }
+
+    /**
+     * @brief Цикл фонового потока.
+     */
+    void run() {
+        while (!stopping.load(memory_order_acquire)) {
+            if (drain() == 0) this_thread::sleep_for(chrono::milliseconds(2));
+        }
+        drain();
+        out.flush();
+    }
+
+public:
+    /**
+     * @brief Создает писатель и запускает фоновый поток.
+     * @param o Поток вывода (должен жить дольше писателя).
+     */
+    explicit TelemetryWriter(ostream& o) : out(o), stopping(false), written(0) {
+        static atomic<uint64_t> serials{ 0 };
+        serial = ++serials;
+        out << "source,day,kind,subject,value\n";
+        worker = thread(&TelemetryWriter::run, this);
+    }
+
+    TelemetryWriter(const TelemetryWriter&) = delete;
+    TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+    /**
+     * @brief Дописывает оставшиеся события и останавливает фоновый поток.
+     */
+    ~TelemetryWriter() {
+        stopping.store(true, memory_order_release);
+        worker.join();
+    }
+
+    /**
+     * @brief Получает буфер вызывающего потока, создавая его при первом обращении.
+     * @return Буфер, в который пишет только текущий поток.
+     */
+    Channel& channel() {
+        thread_local uint64_t ownerSerial = 0;
+        thread_local Channel* cached = nullptr;
+        if (ownerSerial != serial) {
+            lock_guard<mutex> guard(channelsLock);
+            channels.push_back(make_unique<Channel>());
+            cached = channels.back().get();
+            ownerSerial = serial;
+        }
+        return *cached;
+    }
+
+    /**
+     * @brief Получает количество отброшенных событий.
+     * @return Сумма потерь по всем буферам.
+     */
+    uint64_t getDropped() {
+        lock_guard<mutex> guard(channelsLock);
+        uint64_t total = 0;
+        for (auto& c : channels) total += c->dropped.load(memory_order_relaxed);
+        return total;
+    }
+
+    /**
+     * @brief Получает количество записанных событий (точное после остановки писателя).
+     * @return Количество событий.
+     */
+    uint64_t getWritten() const { return written; }
+};
+
+/**
+ * @class TaskPromiseBase
+ * @brief Общая часть обещания сопрограммы Task: продолжение и исключение.
+ */
+class TaskPromiseBase {
+public:
+    /**
+     * @struct Final
+     * @brief По завершении передает управление ожидающей сопрограмме без роста стека.
+     */
+    struct Final {
+        bool await_ready() noexcept { return false; }
+
+        template<typename P>
+        coroutine_handle<> await_suspend(coroutine_handle<P> h) noexcept {
+            coroutine_handle<> next = h.promise().continuation;
+            return next ? next : noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    coroutine_handle<> continuation;       /**< Сопрограмма, ожидающая результата */
+    exception_ptr error;                   /**< Исключение, вышедшее из тела */
+
+    suspend_always initial_suspend() noexcept { return {}; }
+    Final final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { error = current_exception(); }
+};
+
+/**
+ * @brief Обещание сопрограммы, возвращающей значение.
+ */
+template<typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    optional<T> value;                     /**< Результат */
+
+    template<typename U>
+    void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+    T take() { return std::move(*value); }
+};
+
+/**
+ * @brief Обещание сопрограммы без результата.
+ */
+template<>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    void return_void() {}
+    void take() {}
+};
+
+/**
+ * @class Task
+ * @brief Ленивая сопрограмма: начинает работу при co_await (или start()) и возвращает результат ожидающему.
+ *
+ * Вложенные меню ожидают друг друга через co_await, а самая внутренняя сопрограмма приостанавливается
+ * на вводе (Console::readLine). Поэтому один поток может вести сколько угодно сессий.
+ * @tparam T Тип результата.
+ */
+template<typename T = void>
+class Task {
+public:
+    struct promise_type : TaskPromise<T> {
+        Task get_return_object() { return Task(coroutine_handle<promise_type>::from_promise(*this)); }
+    };
+
+private:
+    coroutine_handle<promise_type> handle;   /**< Кадр сопрограммы */
+
+    explicit Task(coroutine_handle<promise_type> h) : handle(h) {}
+
+public:
+    Task() = default;
+    Task(Task&& other) noexcept : handle(exchange(other.handle, {})) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = exchange(other.handle, {});
+        }
+        return *this;
+    }
+
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    coroutine_handle<> await_suspend(coroutine_handle<> caller) noexcept {
+        handle.promise().continuation = caller;
+        return handle;
+    }
+
+    T await_resume() {
+        if (handle.promise().error) rethrow_exception(handle.promise().error);
+        return handle.promise().take();
+    }
+
+    /**
+     * @brief Запускает сопрограмму верхнего уровня до первой приостановки.
+     */
+    void start() { handle.resume(); }
+
+    /**
+     * @brief Проверяет, завершилась ли сопрограмма.
+     * @return Истина, если сопрограммы нет или она завершена.
+     */
+    bool done() const { return !handle || handle.done(); }
+
+    /**
+     * @brief Получает результат завершенной сопрограммы верхнего уровня.
+     * @return Результат; исключение из тела пробрасывается.
+     */
+    T get() { return await_resume(); }
+};
+
+/**
+ * @class StringSink
+ * @brief Буфер потока, дописывающий вывод в строку (например, в буфер ответа соединения).
+ */
+class StringSink : public streambuf {
+private:
+    pmr::string* target;                   /**< Строка назначения */
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) target->push_back(traits_type::to_char_type(c));
+        return traits_type::not_eof(c);
+    }
+
+    streamsize xsputn(const char* s, streamsize n) override {
+        target->append(s, static_cast<size_t>(n));
+        return n;
+    }
+
+public:
+    explicit StringSink(pmr::string& t) : target(&t) {}
+};
+
+/**
+ * @class Console
+ * @brief Канал ввода-вывода интерактивной сессии.
+ *
+ * Вывод пишется в заданный поток, а ввод поступает строками через feed() от того, кто владеет
+ * источником (консоль, сокет, сценарий). Сопрограмма меню, ожидающая строку, приостанавливается
+ * и продолжается внутри feed().
+ */
+class Console {
+public:
+    /**
+     * @struct Closed
+     * @brief Исключение, которым ожидание ввода завершается после закрытия источника.
+     */
+    struct Closed : runtime_error {
+        Closed() : runtime_error("Ввод закрыт") {}
+    };
+
+private:
+    ostream& out;                          /**< Поток вывода */
+    deque<string> pending;                 /**< Поступившие, но не прочитанные строки */
+    coroutine_handle<> waiting;            /**< Сопрограмма, ожидающая строку */
+    bool closed;                           /**< Источник ввода закрыт */
+
+    /**
+     * @brief Продолжает ожидающую сопрограмму, если она есть.
+     */
+    void wake() {
+        if (waiting) exchange(waiting, {}).resume();
+    }
+
+public:
+    explicit Console(ostream& o) : out(o), closed(false) {}
+
+    Console(const Console&) = delete;
+    Console& operator=(const Console&) = delete;
+
+    /**
+     * @brief Получает поток вывода сессии.
+     * @return Поток вывода.
+     */
+    ostream& output() { return out; }
+
+    /**
+     * @brief Ожидает строку ввода.
+     * @return Объект ожидания; co_await дает строку или бросает Closed.
+     */
+    auto readLine() {
+        struct LineAwaiter {
+            Console& console;
+            bool await_ready() const noexcept { return !console.pending.empty() || console.closed; }
+            void await_suspend(coroutine_handle<> h) noexcept { console.waiting = h; }
+            string await_resume() {
+                if (console.pending.empty()) throw Closed();
+                string line = std::move(console.pending.front());
+                console.pending.pop_front();
+                return line;
+            }
+        };
+        return LineAwaiter{ *this };
+    }
+
+    /**
+     * @brief Передает строку ввода сессии.
+     * @param line Строка без перевода строки.
+     */
+    void feed(string line) {
+        pending.push_back(std::move(line));
+        wake();
+    }
+
+    /**
+     * @brief Сообщает, что ввода больше не будет.
+     */
+    void close() {
+        closed = true;
+        wake();
+    }
+
+    /**
+     * @brief Забывает ожидающую сопрограмму и непрочитанный ввод (перед уничтожением сопрограммы).
+     */
+    void detach() {
+        waiting = {};
+        pending.clear();
+    }
+};
+
+/**
+ * @class MemoryBudget
+ * @brief Учет и жесткое ограничение памяти хранилищ сущностей.
+ *
+ * Стоит между контейнерами и пулом сущностей и считает байты, запрошенные контейнерами. Пул держит
+ * освобожденные блоки у себя, поэтому учет над пулом показывает объем живых данных, а не размер
+ * кусков, полученных от системы. Выделение сверх лимита завершается bad_alloc — это последний рубеж:
+ * зоопарк проверяет запас заранее и при нехватке действует по своей политике (CapPolicy).
+ */
+class MemoryBudget : public pmr::memory_resource {
+private:
+    pmr::memory_resource* upstream; /**< Ресурс, из которого берутся блоки */
+    size_t limit;                   /**< Лимит в байтах (0 — без ограничения) */
+    size_t used;                    /**< Занято байт */
+    size_t peak;                    /**< Наибольший занятый объем */
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        if (bytes > getHeadroom()) throw bad_alloc();
+        void* p = upstream->allocate(bytes, alignment);
+        used += bytes;
+        peak = max(peak, used);
+        return p;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        upstream->deallocate(p, bytes, alignment);
+        used -= bytes;
+    }
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+public:
+    /**
+     * @brief Создает учет памяти.
+     * @param up Ресурс, из которого берутся блоки.
+     * @param lim Лимит в байтах (0 — без ограничения).
+     */
+    explicit MemoryBudget(pmr::memory_resource* up, size_t lim = 0) : upstream(up), limit(lim), used(0), peak(0) {}
+
+    /**
+     * @brief Задает лимит.
+     * @param lim Лимит в байтах (0 — без ограничения).
+     */
+    void setLimit(size_t lim) { limit = lim; }
+
+    /**
+     * @brief Получает лимит.
+     * @return Лимит в байтах (0 — без ограничения).
+     */
+    size_t getLimit() const { return limit; }
+
+    /**
+     * @brief Получает занятый объем.
+     * @return Байты, выделенные и еще не освобожденные.
+     */
+    size_t getUsed() const { return used; }
+
+    /**
+     * @brief Получает наибольший занятый объем.
+     * @return Байты.
+     */
+    size_t getPeak() const { return peak; }
+
+    /**
+     * @brief Получает оставшийся запас.
+     * @return Байты до лимита (максимум size_t, если лимита нет).
+     */
+    size_t getHeadroom() const {
+        if (limit == 0) return numeric_limits<size_t>::max();
+        return limit > used ? limit - used : 0;
+    }
+};
+
+/**
+ * @class ZooMemory
+ * @brief Ресурсы памяти зоопарка.
+ *
+ * Долгоживущие справочные данные (каталог рынка) размещаются в монотонном ресурсе и освобождаются только
+ * вместе с зоопарком. Сущности с частым созданием и удалением (животные, работники, кредиты, вольеры)
+ * берут память из несинхронизированного пула: зоопарк принадлежит одному потоку, поэтому блокировки не нужны,
+ * а освобожденные блоки переиспользуются без обращения к общему аллокатору. Запросы к пулу идут через
+ * MemoryBudget, который считает занятую сущностями память и ограничивает ее.
+ */
+class ZooMemory {
+private:
+    pmr::memory_resource* upstream;            /**< Источник памяти для обоих ресурсов */
+    pmr::monotonic_buffer_resource catalog;    /**< Ресурс справочных данных */
+    pmr::unsynchronized_pool_resource entities;/**< Пул сущностей */
+    MemoryBudget budget;                       /**< Учет памяти сущностей поверх пула */
+
+public:
+    /**
+     * @brief Создает ресурсы памяти зоопарка.
+     * @param up Источник памяти (по умолчанию ресурс по умолчанию процесса).
+     */
+    explicit ZooMemory(pmr::memory_resource* up = pmr::get_default_resource())
+        : upstream(up), catalog(up), entities(up), budget(&entities) {
+    }
+
+    ZooMemory(const ZooMemory&) = delete;
+    ZooMemory& operator=(const ZooMemory&) = delete;
+
+    /**
+     * @brief Получает источник памяти.
+     * @return Ресурс, из которого берутся блоки.
+     */
+    pmr::memory_resource* getUpstream() const { return upstream; }
+
+    /**
+     * @brief Получает ресурс для справочных данных.
+     * @return Монотонный ресурс.
+     */
+    pmr::memory_resource* getCatalog() { return &catalog; }
+
+    /**
+     * @brief Получает ресурс для сущностей.
+     * @return Учитываемый бюджетом пул.
+     */
+    pmr::memory_resource* getEntities() { return &budget; }
+
+    /**
+     * @brief Получает учет памяти сущностей.
+     * @return Ссылка на бюджет.
+     */
+    MemoryBudget& getBudget() { return budget; }
+
+    /**
+     * @brief Получает учет памяти сущностей.
+     * @return Константная ссылка на бюджет.
+     */
+    const MemoryBudget& getBudget() const { return budget; }
+};
+
+/**
+ * @struct StandardRules
+ * @brief Правила обычной игры на 20 дней.
+ *
+ * Набор правил — параметр шаблона BasicZoo. Значения объявлены как constexpr, поэтому в зоопарке,
+ * собранном с этими правилами, они подставляются в код дня как константы. Варианты наследуют
+ * стандартные правила и переопределяют нужные значения.
+ */
+struct StandardRules {
+    static constexpr double startingMoney = 1488;      /**< Деньги в начале игры */
+    static constexpr int startingFood = 100;           /**< Еда в начале игры */
+    static constexpr double startingPopularity = 50;   /**< Популярность в начале игры */
+    static constexpr int maxDays = 20;                 /**< Длина игры в днях */
+    static constexpr int sicknessPercent = 10;         /**< Вероятность заболеть за день, % */
+    static constexpr int starvationPercent = 30;       /**< Вероятность умереть в голодный день, % */
+    static constexpr int oldAgeDays = 30;              /**< Возраст, после которого животное может умереть от старости */
+    static constexpr int foodPrice = 2;                /**< Цена единицы еды */
+    static constexpr int marketRefreshCost = 50;       /**< Цена обновления рынка */
+    static constexpr int enclosureSlotCost = 50;       /**< Цена места при строительстве вольера */
+    static constexpr int enclosureSlotUpkeep = 2;      /**< Дневное содержание места в вольере */
+    static constexpr int freePurchaseDays = 10;        /**< До какого дня покупки животных не ограничены */
+    static constexpr double loanDailyRate = 0.005;     /**< Дневная процентная ставка кредита */
+};
+
+/**
+ * @struct HardcoreRules
+ * @brief Тяжелый вариант: меньше денег, чаще болезни и голод, дороже еда, ограничение покупок с 5-го дня.
+ */
+struct HardcoreRules : StandardRules {
+    static constexpr double startingMoney = 1200;
+    static constexpr int sicknessPercent = 20;
+    static constexpr int starvationPercent = 50;
+    static constexpr int foodPrice = 3;
+    static constexpr int freePurchaseDays = 5;
+    static constexpr double loanDailyRate = 0.01;
+};
+
+/**
+ * @struct SandboxRules
+ * @brief Песочница: большой капитал, без болезней и голода, год игры без ограничения покупок.
+ */
+struct SandboxRules : StandardRules {
+    static constexpr double startingMoney = 1000000;
+    static constexpr int sicknessPercent = 0;
+    static constexpr int starvationPercent = 0;
+    static constexpr int maxDays = 365;
+    static constexpr int freePurchaseDays = 365;
+};
+
+/**
+ * @struct RuntimeRules
+ * @brief Правила, задаваемые во время выполнения (для перебора параметров).
+ *
+ * Поля совпадают по именам с константами StandardRules и по умолчанию равны им.
+ */
+struct RuntimeRules {
+    double startingMoney = StandardRules::startingMoney;           /**< Деньги в начале игры */
+    int startingFood = StandardRules::startingFood;                /**< Еда в начале игры */
+    double startingPopularity = StandardRules::startingPopularity; /**< Популярность в начале игры */
+    int maxDays = StandardRules::maxDays;                          /**< Длина игры в днях */
+    int sicknessPercent = StandardRules::sicknessPercent;          /**< Вероятность заболеть за день, % */
+    int starvationPercent = StandardRules::starvationPercent;      /**< Вероятность умереть в голодный день, % */
+    int oldAgeDays = StandardRules::oldAgeDays;                    /**< Возраст начала смертей от старости */
+    int foodPrice = StandardRules::foodPrice;                      /**< Цена единицы еды */
+    int marketRefreshCost = StandardRules::marketRefreshCost;      /**< Цена обновления рынка */
+    int enclosureSlotCost = StandardRules::enclosureSlotCost;      /**< Цена места при строительстве вольера */
+    int enclosureSlotUpkeep = StandardRules::enclosureSlotUpkeep;  /**< Дневное содержание места в вольере */
+    int freePurchaseDays = StandardRules::freePurchaseDays;        /**< До какого дня покупки не ограничены */
+    double loanDailyRate = StandardRules::loanDailyRate;           /**< Дневная процентная ставка кредита */
+
+    /**
+     * @brief Переносит значения набора правил времени компиляции.
+     * @tparam Rules Набор правил (StandardRules, HardcoreRules, SandboxRules).
+     * @return Правила с теми же значениями.
+     */
+    template<class Rules>
+    static RuntimeRules from() {
+        return { Rules::startingMoney, Rules::startingFood, Rules::startingPopularity, Rules::maxDays, Rules::sicknessPercent,
+            Rules::starvationPercent, Rules::oldAgeDays, Rules::foodPrice, Rules::marketRefreshCost, Rules::enclosureSlotCost,
+            Rules::enclosureSlotUpkeep, Rules::freePurchaseDays, Rules::loanDailyRate };
+    }
+
+    /**
+     * @brief Задает параметр по имени поля.
+     * @param name Имя поля (например, sicknessPercent).
+     * @param value Значение; для целочисленных полей округляется.
+     * @throws runtime_error Если поля с таким именем нет или значение вне его диапазона (проценты — от 0 до 100,
+     * цены, деньги и сроки — не меньше 0).
+     */
+    void set(string_view name, double value) {
+        const Field& f = field(name);
+        if (!(value >= f.low && value <= f.high)) {
+            auto text = [](double v) {
+                char buffer[32];
+                return string(buffer, to_chars(buffer, buffer + sizeof(buffer), v).ptr);
+            };
+            string range = f.high >= numeric_limits<int>::max() ? "не меньше " + text(f.low) : "от " + text(f.low) + " до " + text(f.high);
+            throw runtime_error("Значение " + string(name) + " должно быть " + range + ": " + text(value) + ".");
+        }
+        if (f.real) this->*f.real = value;
+        else this->*f.whole = static_cast<int>(lround(value));
+    }
+
+    /**
+     * @brief Получает параметр по имени поля.
+     * @param name Имя поля.
+     * @return Значение.
+     * @throws runtime_error Если поля с таким именем нет.
+     */
+    double get(string_view name) const {
+        const Field& f = field(name);
+        return f.real ? this->*f.real : this->*f.whole;
+    }
+
+    /**
+     * @brief Задает параметры из списка «поле=значение» через запятую (например, sicknessPercent=13,foodPrice=2).
+     * @param text Список параметров.
+     * @throws runtime_error При ошибке формата, неизвестном поле или значении вне диапазона поля.
+     */
+    void assign(string_view text) {
+        for (size_t pos = 0; pos <= text.size();) {
+            size_t end = min(text.find(',', pos), text.size());
+            string_view item = text.substr(pos, end - pos);
+            pos = end + 1;
+            size_t eq = item.find('=');
+            if (eq == string_view::npos) throw runtime_error("Ожидалось «поле=значение»: " + string(item) + ".");
+            string_view token = item.substr(eq + 1);
+            double value = 0;
+            auto [last, ec] = from_chars(token.data(), token.data() + token.size(), value);
+            if (ec != errc() || last != token.data() + token.size()) throw runtime_error("Ожидалось число: " + string(token) + ".");
+            set(item.substr(0, eq), value);
+        }
+    }
+
+private:
+    /**
+     * @struct Field
+     * @brief Поле правил для доступа по имени.
+     */
+    struct Field {
+        string_view name;              /**< Имя поля */
+        double RuntimeRules::* real;   /**< Вещественное поле (или nullptr) */
+        int RuntimeRules::* whole;     /**< Целочисленное поле (или nullptr) */
+        double low;                    /**< Наименьшее допустимое значение */
+        double high;                   /**< Наибольшее допустимое значение */
+    };
+
+    /**
+     * @brief Находит поле по имени.
+     * @param name Имя поля.
+     * @return Описание поля.
+     * @throws runtime_error Если поля с таким именем нет.
+     */
+    static const Field& field(string_view name) {
+        constexpr double money = numeric_limits<double>::max(), count = numeric_limits<int>::max();
+        static constexpr Field fields[] = { { "startingMoney", &RuntimeRules::startingMoney, nullptr, 0, money },
+            { "startingFood", nullptr, &RuntimeRules::startingFood, 0, count },
+            { "startingPopularity", &RuntimeRules::startingPopularity, nullptr, 0, money },
+            { "maxDays", nullptr, &RuntimeRules::maxDays, 1, count }, { "sicknessPercent", nullptr, &RuntimeRules::sicknessPercent, 0, 100 },
+            { "starvationPercent", nullptr, &RuntimeRules::starvationPercent, 0, 100 },
+            { "oldAgeDays", nullptr, &RuntimeRules::oldAgeDays, 0, count }, { "foodPrice", nullptr, &RuntimeRules::foodPrice, 0, count },
+            { "marketRefreshCost", nullptr, &RuntimeRules::marketRefreshCost, 0, count },
+            { "enclosureSlotCost", nullptr, &RuntimeRules::enclosureSlotCost, 0, count },
+            { "enclosureSlotUpkeep", nullptr, &RuntimeRules::enclosureSlotUpkeep, 0, count },
+            { "freePurchaseDays", nullptr, &RuntimeRules::freePurchaseDays, 0, count },
+            { "loanDailyRate", &RuntimeRules::loanDailyRate, nullptr, 0, 1 } };
+        auto it = find_if(begin(fields), end(fields), [name](const Field& f) { return f.name == name; });
+        if (it == end(fields)) throw runtime_error("Неизвестный параметр правил: " + string(name) + ".");
+        return *it;
+    }
+};
+
+/**
+ * @struct AnimalQuery
+ * @brief Запрос к животным зоопарка: фильтры, порядок и размер страницы.
+ *
+ * Текстовая форма — пары «ключ=значение» через пробел: вид=Белый_медведь, вольер=2, пол=ж, болен=да,
+ * возраст=10-30 (или 10-, -30, 10), рожден=нет, сорт=-возраст (минус — по убыванию; ключи сортировки:
+ * id, возраст, цена, вес). Без ключа сорт животные идут в порядке поступления в зоопарк.
+ */
+struct AnimalQuery {
+    /**
+     * @enum SortKey
+     * @brief Порядок результатов.
+     */
+    enum class SortKey {
+        ARRIVAL,  /**< Порядок поступления (без сортировки) */
+        ID,       /**< Идентификатор */
+        AGE,      /**< Возраст */
+        PRICE,    /**< Цена */
+        WEIGHT    /**< Вес */
+    };
+
+    optional<uint16_t> species;        /**< Вид */
+    optional<int> enclosure;           /**< Вольер */
+    optional<Gender> gender;           /**< Пол */
+    optional<bool> sick;               /**< Болеет ли */
+    optional<bool> bornInZoo;          /**< Родилось ли в зоопарке */
+    int minAge = 0;                    /**< Наименьший возраст (включительно) */
+    int maxAge = numeric_limits<int>::max(); /**< Наибольший возраст (включительно) */
+    SortKey sort = SortKey::ARRIVAL;   /**< Порядок */
+    bool descending = false;           /**< По убыванию */
+
+    /**
+     * @brief Проверяет, подходит ли животное под фильтры.
+     * @param a Животное.
+     * @return Истина, если подходит.
+     */
+    bool matches(const Animal& a) const {
+        return (!species || a.getSpeciesId() == *species) && (!enclosure || a.getEnclosureId() == *enclosure)
+            && (!gender || a.getGender() == *gender) && (!sick || a.getIsSick() == *sick)
+            && (!bornInZoo || a.getIsBornInZoo() == *bornInZoo) && a.getAgeDays() >= minAge && a.getAgeDays() <= maxAge;
+    }
+
+    /**
+     * @brief Получает значение ключа сортировки животного.
+     * @param a Животное.
+     * @return Значение ключа.
+     */
+    double sortValue(const Animal& a) const {
+        switch (sort) {
+        case SortKey::ID: return a.getUniqueId();
+        case SortKey::AGE: return a.getAgeDays();
+        case SortKey::PRICE: return a.getPrice();
+        case SortKey::WEIGHT: return a.getWeight();
+        default: return 0;
+        }
+    }
+
+    /**
+     * @brief Разбирает текстовую форму запроса.
+     * @param text Текст запроса.
+     * @param registry Справочник видов зоопарка.
+     * @return Запрос.
+     * @throws runtime_error Если ключ или значение не распознаны.
+     */
+    static AnimalQuery parse(string_view text, const SpeciesRegistry& registry) {
+        AnimalQuery query;
+        auto number = [](string_view value) {
+            int result;
+            auto [end, ec] = from_chars(value.data(), value.data() + value.size(), result);
+            if (ec != errc() || end != value.data() + value.size() || result < 0) {
+                throw runtime_error("Ожидалось неотрицательное число: " + string(value) + ".");
+            }
+            return result;
+        };
+        auto yesNo = [](string_view value) {
+            if (value == "да") return true;
+            if (value == "нет") return false;
+            throw runtime_error("Ожидалось «да» или «нет»: " + string(value) + ".");
+        };
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t start = text.find_first_not_of(" \t\r", pos);
+            if (start == string_view::npos) break;
+            size_t end = min(text.find_first_of(" \t\r", start), text.size());
+            string_view token = text.substr(start, end - start);
+            pos = end;
+            size_t eq = token.find('=');
+            if (eq == string_view::npos) throw runtime_error("Ожидалось «ключ=значение»: " + string(token) + ".");
+            string_view key = token.substr(0, eq), value = token.substr(eq + 1);
+            if (key == "вид") {
+                string name(value);
+                replace(name.begin(), name.end(), '_', ' ');
+                query.species = registry.find(name);
+                if (!query.species) throw runtime_error("Неизвестный вид: " + name + ".");
+            }
+            else if (key == "вольер") query.enclosure = number(value);
+            else if (key == "пол") {
+                if (value == "м" || value == "М") query.gender = Gender::MALE;
+                else if (value == "ж" || value == "Ж") query.gender = Gender::FEMALE;
+                else throw runtime_error("Пол задается буквой м или ж.");
+            }
+            else if (key == "болен") query.sick = yesNo(value);
+            else if (key == "рожден") query.bornInZoo = yesNo(value);
+            else if (key == "возраст") {
+                size_t dash = value.find('-');
+                if (dash == string_view::npos) query.minAge = query.maxAge = number(value);
+                else {
+                    if (dash > 0) query.minAge = number(value.substr(0, dash));
+                    if (dash + 1 < value.size()) query.maxAge = number(value.substr(dash + 1));
+                }
+            }
+            else if (key == "сорт") {
+                query.descending = !value.empty() && value.front() == '-';
+                if (query.descending) value.remove_prefix(1);
+                if (value == "id") query.sort = SortKey::ID;
+                else if (value == "возраст") query.sort = SortKey::AGE;
+                else if (value == "цена") query.sort = SortKey::PRICE;
+                else if (value == "вес") query.sort = SortKey::WEIGHT;
+                else throw runtime_error("Неизвестный ключ сортировки: " + string(value) + ".");
+            }
+            else throw runtime_error("Неизвестный фильтр: " + string(key) + ".");
+        }
+        return query;
+    }
+};
+
+/**
+ * @struct AnimalPage
+ * @brief Страница результатов запроса к животным.
+ */
+struct AnimalPage {
+    vector<uint32_t> ids;   /**< Идентификаторы животных страницы */
+    bool more = false;      /**< Есть ли следующая страница */
+};
+
+/**
+ * @struct BatchResult
+ * @brief Итог пакетной команды (покупка, продажа или назначение многих единиц за один вызов).
+ */
+struct BatchResult {
+    bool ok = false;       /**< Команда выполнена (возможно, частично) */
+    size_t applied = 0;    /**< Сколько единиц действия выполнено */
+    double money = 0;      /**< Изменение денег */
+    string message;        /**< Итог или причина отказа для игрока */
+};
+
+/**
+ * @struct StatusSummary
+ * @brief Сводка состояния зоопарка для подробного отчета.
+ */
+struct StatusSummary {
+    /**
+     * @struct EnclosureLine
+     * @brief Заполненность и здоровье одного вольера.
+     */
+    struct EnclosureLine {
+        int id;                /**< Идентификатор вольера */
+        size_t animals;        /**< Животных в вольере (включая когорты) */
+        int capacity;          /**< Вместимость */
+        size_t sick;           /**< Больных животных */
+        bool hasVeterinarian;  /**< Назначен ли ветеринар */
+    };
+
+    /**
+     * @struct RoleLine
+     * @brief Покрытие вольеров работниками одной роли.
+     */
+    struct RoleLine {
+        WorkerType type;       /**< Роль */
+        size_t workers;        /**< Работников роли */
+        size_t covered;        /**< Вольеров, на которые назначен хотя бы один работник роли */
+    };
+
+    /**
+     * @struct SpeciesLine
+     * @brief Численность одного вида.
+     */
+    struct SpeciesLine {
+        string name;           /**< Название вида */
+        long long animals;     /**< Животных вида (включая когорты) */
+    };
+
+    uint64_t generation = 0;           /**< Поколение изменений, для которого построена сводка */
+    int day = 0;                       /**< День */
+    double money = 0;                  /**< Деньги */
+    int food = 0;                      /**< Еда */
+    double popularity = 0;             /**< Популярность */
+    long long animals = 0;             /**< Всего животных */
+    long long sick = 0;                /**< Всего больных */
+    long long sickUntreated = 0;       /**< Больных в вольерах без ветеринара */
+    long long elderly = 0;             /**< Животных старше Rules::oldAgeDays */
+    long long foodDemand = 0;          /**< Дневная потребность в еде */
+    size_t loans = 0;                  /**< Активных кредитов */
+    double loanPayments = 0;           /**< Платежи по кредитам в конце дня */
+    double debt = 0;                   /**< Оставшийся долг */
+    vector<EnclosureLine> enclosures;  /**< Вольеры */
+    vector<RoleLine> roles;            /**< Роли работников */
+    vector<SpeciesLine> species;       /**< Виды, представленные в зоопарке */
+};
+
+/**
+ * @struct RollSampling
+ * @brief Согласованная выборка случайных бросков для уменьшения дисперсии пакетных оценок.
+ *
+ * Броски старения и болезни — равномерные числа от 0 до 99, вычисляемые по ключу (зерно бросков, день,
+ * животное). Зеркальный прогон берет вместо броска r бросок 99 - r, а вместо случайного числа зоопарка v из
+ * [min, max] — min + max - v (антитетическая пара с обычным прогоном того же зерна). Прогон со сдвигом k из
+ * shifts поворачивает броски на 100k / shifts по модулю 100, так что у прогонов с общим зерном бросков бросок
+ * каждого ключа пробегает равномерную сетку. Это только поворот бросков, а не расслоение: ни зерно, ни исход
+ * прогона по слоям не распределяются, и дисперсия падает лишь настолько, насколько исход зависит от бросков
+ * старения и болезни. Любое из преобразований оставляет каждый бросок равномерным, поэтому отдельный прогон
+ * остается несмещенным.
+ */
+struct RollSampling {
+    optional<uint64_t> rollSeed; /**< Зерно бросков (по умолчанию — зерно зоопарка) */
+    bool mirrored = false;       /**< Зеркальный прогон */
+    uint32_t shifts = 1;         /**< Число сдвигов бросков */
+    uint32_t shift = 0;          /**< Сдвиг прогона (меньше shifts) */
+
+    /**
+     * @brief Проверяет, оставляет ли выборка броски без изменений.
+     * @return Истина для обычного прогона.
+     */
+    bool identity() const { return !mirrored && shift == 0; }
+
+    /**
+     * @brief Преобразует бросок.
+     * @param roll Бросок от 0 до 99.
+     * @return Бросок этого прогона.
+     */
+    uint8_t apply(uint8_t roll) const {
+        int value = mirrored ? 99 - roll : roll;
+        return static_cast<uint8_t>((value + static_cast<int>(100ull * shift / shifts)) % 100);
+    }
+};
+
+/**
+ * @class BasicZoo
+ * @brief Представляет зоопарк и его операции.
+ *
+ * Управляет всеми аспектами зоопарка, включая животных, вольеры, работников, финансы и прогресс игры.
+ * @tparam Rules Набор правил (StandardRules, HardcoreRules, SandboxRules или RuntimeRules).
+ */
+template<class Rules>
+class BasicZoo {
+public:
+    /**
+     * @struct Snapshot
+     * @brief Версия состояния зоопарка для отмены действий и ветвления планов.
+     *
+     * Животные хранятся в PersistentVector, который зоопарк ведет по ходу дня: покупка, продажа или
+     * переименование меняют в нем один путь дерева, поэтому новая версия делит с предыдущей все остальное.
+     * Списки животных вольеров, позиции и индексы в версию не входят — они восстанавливаются по животным.
+     * Остальное состояние (описания вольеров, работники, кредиты, когорты, рынок) невелико и копируется.
+     */
+    struct Snapshot {
+        /**
+         * @struct Entry
+         * @brief Животное версии в порядке поступления; ушедшие животные остаются на месте с present == false.
+         */
+        struct Entry {
+            Animal animal;         /**< Запись животного */
+            bool present;          /**< Животное в зоопарке */
+            string name;           /**< Собственное имя (пусто, если его нет) */
+        };
+
+        PersistentVector<Entry> animals;           /**< Животные */
+        vector<Enclosure> enclosures;              /**< Вольеры без списков животных */
+        vector<pair<WorkerType, Worker>> workers;  /**< Работники в порядке списка */
+        vector<Loan> loans;                        /**< Кредиты */
+        vector<Cohort> cohorts;                    /**< Когорты */
+        vector<Animal> market;                     /**< Рынок */
+        Rng rng;                                   /**< Состояние генератора */
+        double money = 0;                          /**< Деньги */
+        int food = 0;                              /**< Еда */
+        double popularity = 0;                     /**< Популярность */
+        int day = 0;                               /**< День */
+        int visitors = 0;                          /**< Посетители */
+        long long totalAnimals = 0;                /**< Всего животных */
+        int animalsBoughtToday = 0;                /**< Куплено сегодня */
+        string specialVisitorType;                 /**< Тип особых посетителей */
+        int specialVisitorCount = 0;               /**< Количество особых посетителей */
+    };
+
+private:
+    ZooMemory memory;              /**< Ресурсы памяти (объявлены первыми, разрушаются последними) */
+    [[no_unique_address]] Rules rules; /**< Правила игры (для constexpr-правил не занимает места) */
+    Rng rng;                       /**< Генератор случайных чисел зоопарка */
+    RngLanes batchRng;             /**< Пакетный генератор для бросков голода по всем животным */
+    uint64_t seed;                 /**< Зерно зоопарка (для бросков, не зависящих от порядка действий) */
+    uint64_t rollSeed;             /**< Зерно бросков старения и болезни (обычно равно seed) */
+    RollSampling sampling;         /**< Преобразование бросков пакетного прогона */
+    DayArena dayArena;             /**< Временная память текущего дня (сбрасывается в nextDay) */
+    string name;                   /**< Название зоопарка */
+    SpeciesRegistry species;       /**< Справочник видов */
+    NameArena names;               /**< Собственные имена животных */
+    Pedigree pedigree;             /**< Родословная всех животных, когда-либо бывших в зоопарке */
+    double money;                  /**< Текущие денежные средства */
+    int food;                      /**< Доступные единицы еды */
+    double popularity;             /**< Очки популярности */
+    pmr::vector<Animal> animals;   /**< Список животных в зоопарке */
+    mutable pmr::vector<uint32_t> positionById; /**< Позиция записи по идентификатору животного */
+    mutable size_t positionsValid; /**< Позиции записей до этой позиции актуальны */
+    GroupIndex bySpecies;          /**< Животные по виду */
+    GroupIndex byBirth;            /**< Животные по периоду рождения (см. birthBucket) */
+    pmr::vector<Enclosure> enclosures; /**< Список вольеров */
+    WorkerRoster workers;          /**< Работники по ролям */
+    pmr::vector<Loan> loans;       /**< Список активных кредитов */
+    CohortStore cohorts;           /**< Безымянные животные популяционного режима */
+    bool populationMode;           /**< Покупать животных в когорты вместо отдельных записей */
+    int day;                       /**< Текущий день в игре */
+    int visitors;                  /**< Количество посетителей сегодня */
+    long long totalAnimals;        /**< Общее количество животных (включая когорты) */
+    string specialVisitorType;     /**< Тип особых посетителей (например, "Знаменитость") */
+    int specialVisitorCount;       /**< Количество особых посетителей */
+    pmr::vector<Animal> catalog;   /**< Каталог видов для рынка (строится один раз) */
+    pmr::vector<Animal> marketAnimals; /**< Животные, доступные для покупки */
+    int animalsBoughtToday;        /**< Животные, купленные сегодня */
+    uint32_t nextAnimalId;         /**< Следующий свободный идентификатор животного */
+    CapPolicy capPolicy;           /**< Поведение при исчерпании бюджета памяти */
+    long long cappedEvents;        /**< Сколько раз сработало ограничение памяти */
+    ostream* log;                  /**< Поток сообщений о событиях дня */
+    TelemetryWriter* telemetry;    /**< Писатель телеметрии (nullptr — телеметрия выключена) */
+    uint32_t telemetrySource;      /**< Номер зоопарка в событиях телеметрии */
+    bool forecastEnabled;          /**< Запускать ли фоновый расчет следующего дня */
+    bool ownMarket;                /**< Обновлять ли собственный рынок зоопарка каждый день */
+    uint64_t generation;           /**< Поколение изменений: растет при каждом изменении состояния */
+    mutable optional<StatusSummary> statusCache; /**< Сводка для текущего поколения (строится по запросу) */
+    optional<StatusSummary> lastReport; /**< Сводка, показанная в прошлом отчете */
+    PersistentVector<typename Snapshot::Entry> journal; /**< Животные текущей версии (ведется, если journalValid) */
+    vector<uint32_t> journalSlot;  /**< Место животного в journal по идентификатору */
+    bool journalValid;             /**< journal соответствует животным зоопарка */
+    vector<shared_ptr<const Snapshot>> versions; /**< Версии текущего дня для отмены и повтора */
+    size_t currentVersion;         /**< Текущая версия в versions */
+    uint64_t versionGeneration;    /**< Поколение изменений, в котором снята текущая версия */
+    static constexpr size_t maxVersions = 64; /**< Наибольшее число хранимых версий */
+    DayForecast forecast;          /**< Фоновый расчет следующего дня (объявлен последним, останавливается первым) */
+
+    /**
+     * @brief Генерирует случайное число в диапазоне.
+     * @param min Минимальное значение (включительно).
+     * @param max Максимальное значение (включительно).
+     * @return Случайное целое число.
+     */
+    int random(int min, int max) {
+        int value = rng.uniform(min, max);
+        return sampling.mirrored ? min + max - value : value;
+    }
+
+    /**
+     * @brief Отмечает изменение состояния зоопарка (сводки прошлых поколений устаревают).
+     */
+    void touch() { ++generation; }
+
+    /**
+     * @brief Строит сводку состояния; больные в вольерах считаются по битовым наборам, численность видов
+     * и пожилые животные — по вторичным индексам, без просмотра всех животных.
+     * @return Сводка для текущего поколения.
+     */
+    StatusSummary buildStatus() const {
+        StatusSummary status;
+        status.generation = generation;
+        status.day = day;
+        status.money = money;
+        status.food = food;
+        status.popularity = popularity;
+        status.animals = totalAnimals;
+        status.foodDemand = dailyFoodDemand();
+        status.loans = loans.size();
+        for (const auto& loan : loans) {
+            status.loanPayments += loan.dailyRepayment;
+            status.debt += loan.getRemainingDebt();
+        }
+        auto coveredBy = [this](int encId, WorkerType type) {
+            bool covered = false;
+            workers.forEachCrew([&](const auto& crew) {
+                using Role = typename decay_t<decltype(crew)>::RoleType;
+                if (Role::type != type || covered) return;
+                for (const auto& worker : crew.members) {
+                    const auto& assigned = worker.getAssignedEnclosures();
+                    if (find(assigned.begin(), assigned.end(), encId) != assigned.end()) covered = true;
+                }
+            });
+            return covered;
+        };
+        for (const auto& enc : enclosures) {
+            size_t sick = enc.countFlag(Enclosure::SICK);
+            for (const auto& c : cohorts.getCohorts()) {
+                if (c.enclosureId == enc.getId()) sick += static_cast<size_t>(c.sick);
+            }
+            bool vet = coveredBy(enc.getId(), WorkerType::VETERINARIAN);
+            status.enclosures.push_back({ enc.getId(), enc.getAnimalCount(), enc.getCapacity(), sick, vet });
+            status.sick += static_cast<long long>(sick);
+            if (!vet) status.sickUntreated += static_cast<long long>(sick);
+        }
+        workers.forEachCrew([&](const auto& crew) {
+            using Role = typename decay_t<decltype(crew)>::RoleType;
+            size_t covered = 0;
+            for (const auto& enc : enclosures) covered += coveredBy(enc.getId(), Role::type) ? 1 : 0;
+            status.roles.push_back({ Role::type, crew.members.size(), covered });
+        });
+        vector<long long> bySpeciesCount(species.size());
+        for (size_t id = 0; id < species.size(); ++id) {
+            bySpeciesCount[id] = static_cast<long long>(bySpecies.group(static_cast<int32_t>(id)).size());
+        }
+        for (const auto& c : cohorts.getCohorts()) {
+            bySpeciesCount[c.speciesId] += static_cast<long long>(c.count);
+            if (day - c.birthDay > rules.oldAgeDays) status.elderly += static_cast<long long>(c.count);
+        }
+        for (size_t id = 0; id < species.size(); ++id) {
+            if (bySpeciesCount[id] == 0) continue;
+            status.species.push_back({ string(species.getName(static_cast<uint16_t>(id))), bySpeciesCount[id] });
+        }
+        forEachOlderThan(rules.oldAgeDays, [&](int32_t, const pmr::vector<uint32_t>& group) {
+            for (uint32_t id : group) status.elderly += findAnimal(id)->getAgeDays() > rules.oldAgeDays ? 1 : 0;
+            return true;
+        });
+        return status;
+    }
+
+    /**
+     * @brief Выбирает случайный пол.
+     * @return Случайный пол.
+     */
+    Gender randomGender() { return random(0, 1) ? Gender::MALE : Gender::FEMALE; }
+
+    /**
+     * @brief Ожидает допустимый ввод пользователя в диапазоне.
+     * @param io Канал сессии.
+     * @param prompt Приглашение для ввода.
+     * @param minVal Минимальное допустимое значение.
+     * @param maxVal Максимальное допустимое значение.
+     * @return Допустимое целое число.
+     */
+    static Task<int> readNumber(Console& io, string_view prompt, int minVal, int maxVal) {
+        while (true) {
+            io.output() << prompt;
+            string line = co_await io.readLine();
+            size_t start = line.find_first_not_of(" \t\r");
+            int value;
+            if (start != string::npos) {
+                auto [end, ec] = from_chars(line.data() + start, line.data() + line.size(), value);
+                if (ec == errc() && value >= minVal && value <= maxVal) co_return value;
+            }
+            io.output() << "Некорректный ввод. Введите число от " << minVal << " до " << maxVal << ".\n";
+        }
+    }
+
+    /**
+     * @brief Формирует приглашение выбора из списка во временной памяти дня.
+     * @param text Начало приглашения (например, "Выберите животное для продажи").
+     * @param count Количество элементов списка.
+     * @return Строка вида "<text> (1-count) или 0 для отмены: ".
+     */
+    pmr::string choicePrompt(string_view text, size_t count) {
+        pmr::string prompt(&dayArena);
+        prompt.append(text).append(" (1-").append(to_string(count)).append(") или 0 для отмены: ");
+        return prompt;
+    }
+
+    /**
+     * @brief Обновляет рынок животных новыми животными.
+     */
+    void refreshMarket() {
+        pmr::vector<uint32_t> order(&dayArena);
+        pmr::vector<Gender> genders(&dayArena);
+        DayForecast::planMarket(rng, catalog.size(), order, genders);
+        fillMarket(order, genders);
+    }
+
+    /**
+     * @brief Заполняет рынок животными из каталога.
+     * @param order Индексы каталога.
+     * @param genders Пол каждого животного.
+     */
+    void fillMarket(const pmr::vector<uint32_t>& order, const pmr::vector<Gender>& genders) {
+        marketAnimals.clear();
+        for (size_t i = 0; i < order.size(); ++i) {
+            const Animal& a = catalog[order[i]];
+            marketAnimals.emplace_back(a.getSpeciesId(), a.getAgeDays(), a.getWeight(), a.getPreferredClimate(),
+                a.getPrice(), a.getType(), genders[i]);
+            marketAnimals.back().setUniqueId(nextAnimalId++);
+        }
+    }
+
+    /**
+     * @brief Запускает фоновый расчет следующего дня по текущему составу зоопарка.
+     */
+    void startForecast() {
+        if (!forecastEnabled) return;
+        try {
+            forecast.start(seed, day + 1, catalog.size(), [this](pmr::vector<uint32_t>& ids) {
+                ids.reserve(animals.size());
+                for (const auto& animal : animals) ids.push_back(animal.getUniqueId());
+            });
+        }
+        catch (const bad_alloc&) {
+            forecast.discard(); // без расчета nextDay посчитает броски на месте
+        }
+    }
+
+    /**
+     * @brief Получает броски старения и болезни всех животных на текущий день.
+     *
+     * Без фонового расчета броски старения вычисляются только для животных из elders: остальным
+     * смерть от старости сегодня не грозит, и их бросок не используется. Броски проходят преобразование
+     * выборки (см. RollSampling).
+     * @param ids Идентификаторы животных.
+     * @param elders Номера животных в ids, которые могут умереть от старости.
+     * @param precomputed Истина, если фоновый расчет этого дня готов и сделан с зерном бросков.
+     * @param aging Броски старения (заполняется; для животных не из elders может остаться нулевым).
+     * @param sickness Броски болезни (заполняется).
+     */
+    void dayRolls(const pmr::vector<uint32_t>& ids, const pmr::vector<uint32_t>& elders, bool precomputed, uint8_t* aging,
+        uint8_t* sickness) {
+        if (!precomputed) {
+            pmr::vector<uint32_t> elderIds(&dayArena);
+            pmr::vector<uint8_t> elderRolls(elders.size(), &dayArena);
+            elderIds.reserve(elders.size());
+            for (uint32_t index : elders) elderIds.push_back(ids[index]);
+            AnimalKernels::rollPercents(Rng::keyedPrefix(rollSeed, day, DayForecast::agingStream), elderIds.data(), elderIds.size(),
+                elderRolls.data());
+            for (size_t k = 0; k < elders.size(); ++k) aging[elders[k]] = elderRolls[k];
+            AnimalKernels::rollPercents(Rng::keyedPrefix(rollSeed, day, DayForecast::sicknessStream), ids.data(), ids.size(),
+                sickness);
+        }
+        else {
+            for (size_t i = 0; i < ids.size(); ++i) {
+                const DayForecast::Rolls* found = forecast.find(ids[i]);
+                DayForecast::Rolls r = found ? *found : DayForecast::rollAnimal(seed, day, ids[i]);
+                aging[i] = r.aging;
+                sickness[i] = r.sickness;
+            }
+        }
+        if (sampling.identity()) return;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            aging[i] = sampling.apply(aging[i]);
+            sickness[i] = sampling.apply(sickness[i]);
+        }
+    }
+
+    /**
+     * @brief Получает название вида животного.
+     * @param animal Животное.
+     * @return Название вида.
+     */
+    const pmr::string& speciesName(const Animal& animal) const { return species.getName(animal.getSpeciesId()); }
+
+    /**
+     * @brief Получает отображаемое имя животного.
+     * @param animal Животное.
+     * @return Собственное имя из таблицы имен или название вида.
+     */
+    string_view displayName(const Animal& animal) const {
+        return animal.getHasCustomName() ? names.get(animal.getUniqueId()) : string_view(speciesName(animal));
+    }
+
+    /**
+     * @brief Получает отображаемое имя животного по идентификатору.
+     * @param id Идентификатор животного.
+     * @return Имя животного, если оно в зоопарке, иначе "<вид> #<id>".
+     */
+    pmr::string displayNameById(uint32_t id) {
+        pmr::string result(&dayArena);
+        if (!pedigree.contains(id)) return result.append("#").append(to_string(id));
+        string_view custom = names.get(id);
+        if (!custom.empty()) return result.assign(custom);
+        result.assign(species.getName(pedigree.getSpeciesId(id)));
+        if (!pedigree.isPresent(id)) result.append(" #").append(to_string(id));
+        return result;
+    }
+
+    /**
+     * @brief Задает собственное имя животного.
+     * @param animal Животное.
+     * @param name Новое имя.
+     */
+    void setDisplayName(Animal& animal, string_view name) {
+        names.set(animal.getUniqueId(), name);
+        animal.setHasCustomName(true);
+        journalUpdate(animal, true);
+        touch();
+    }
+
+    /**
+     * @brief Освобождает данные, хранящиеся вне записи удаляемого животного.
+     * @param animal Удаляемое животное.
+     */
+    void forgetAnimal(const Animal& animal) {
+        if (animal.getHasCustomName()) names.erase(animal.getUniqueId());
+        pedigree.markDeparted(animal.getUniqueId());
+    }
+
+    /**
+     * @brief Отправляет событие в телеметрию, если она подключена.
+     * @param kind Вид события.
+     * @param subject Объект события.
+     * @param value Значение.
+     */
+    void emit(TelemetryKind kind, uint32_t subject, double value) {
+        if (telemetry) telemetry->channel().push({ value, telemetrySource, day, subject, kind });
+    }
+
+    /**
+     * @brief Отмечает конец фазы дня и отправляет ее длительность в телеметрию.
+     * @param phase Номер фазы (0 — рынок и старение, 1 — здоровье, 2 — кормление, 3 — экономика).
+     * @param start Начало фазы; заменяется началом следующей.
+     */
+    void phaseDone(uint32_t phase, chrono::steady_clock::time_point& start) {
+        if (!telemetry) return;
+        auto now = chrono::steady_clock::now();
+        emit(TelemetryKind::PHASE_TIME, phase, chrono::duration<double, nano>(now - start).count());
+        start = now;
+    }
+
+    static constexpr uint32_t noPosition = numeric_limits<uint32_t>::max(); /**< Животного нет в зоопарке */
+    static constexpr size_t pageSize = 20; /**< Животных на странице списка */
+    static constexpr int32_t birthBucketDays = 8; /**< Ширина периода рождения в индексе byBirth */
+
+    /**
+     * @brief Получает ключ периода рождения для индекса byBirth.
+     *
+     * Возраст всех животных растет на день вместе с номером дня, поэтому день рождения (день минус возраст)
+     * не меняется, и животное остается в своей группе до удаления.
+     * @param birthDay День рождения (не меньше -65536: возраст не больше 65535).
+     * @return Ключ группы.
+     */
+    static int32_t birthBucket(int birthDay) { return (birthDay + 65536) / birthBucketDays; }
+
+    /**
+     * @brief Добавляет запись животного в конец списка зоопарка и во вторичные индексы.
+     * @param animal Животное с идентификатором этого зоопарка.
+     */
+    void appendAnimal(const Animal& animal) {
+        uint32_t id = static_cast<uint32_t>(animal.getUniqueId());
+        if (id >= positionById.size()) positionById.resize(id + 1, noPosition);
+        if (positionsValid == animals.size()) {
+            positionById[id] = static_cast<uint32_t>(animals.size());
+            positionsValid++;
+        }
+        bySpecies.insert(animal.getSpeciesId(), id);
+        byBirth.insert(birthBucket(day - animal.getAgeDays()), id);
+        animals.push_back(animal);
+        if (journalValid) {
+            if (id >= journalSlot.size()) journalSlot.resize(id + 1, noPosition);
+            journalSlot[id] = static_cast<uint32_t>(journal.size());
+            journal = journal.push_back(journalEntry(animal));
+        }
+    }
+
+    /**
+     * @brief Формирует запись животного для версии.
+     * @param animal Животное.
+     * @return Запись с собственным именем животного.
+     */
+    typename Snapshot::Entry journalEntry(const Animal& animal) const {
+        return { animal, true, animal.getHasCustomName() ? string(names.get(animal.getUniqueId())) : string() };
+    }
+
+    /**
+     * @brief Отражает в журнале версий изменение или уход животного.
+     * @param animal Животное зоопарка (запись уже изменена).
+     * @param present Ложь, если животное покидает зоопарк.
+     */
+    void journalUpdate(const Animal& animal, bool present) {
+        uint32_t id = static_cast<uint32_t>(animal.getUniqueId());
+        if (!journalValid || id >= journalSlot.size() || journalSlot[id] == noPosition) return;
+        typename Snapshot::Entry entry = journalEntry(animal);
+        entry.present = present;
+        journal = journal.set(journalSlot[id], std::move(entry));
+        if (!present) journalSlot[id] = noPosition;
+    }
+
+    /**
+     * @brief Удаляет запись животного из списка зоопарка.
+     *
+     * Позиции следующих записей пересчитываются не сразу, а при следующем поиске по идентификатору,
+     * поэтому серия удалений за день обходится одним проходом.
+     * @param it Удаляемая запись.
+     * @return Итератор на следующую запись.
+     */
+    pmr::vector<Animal>::iterator eraseAnimal(pmr::vector<Animal>::iterator it) {
+        size_t position = static_cast<size_t>(it - animals.begin());
+        uint32_t id = static_cast<uint32_t>(it->getUniqueId());
+        positionById[id] = noPosition;
+        positionsValid = min(positionsValid, position);
+        bySpecies.erase(id);
+        byBirth.erase(id);
+        journalUpdate(*it, false);
+        return animals.erase(it);
+    }
+
+    /**
+     * @brief Удаляет за один проход все записи животных, для которых pred вернул истину.
+     *
+     * В отличие от серии вызовов eraseAnimal, оставшиеся записи сдвигаются один раз.
+     * @param pred Функция, получающая запись; вызывается по разу для каждой записи в порядке списка.
+     * @return Количество удаленных записей.
+     */
+    template<class Pred>
+    size_t eraseAnimalsIf(Pred&& pred) {
+        auto kept = animals.begin();
+        for (auto it = animals.begin(); it != animals.end(); ++it) {
+            if (pred(*it)) {
+                uint32_t id = static_cast<uint32_t>(it->getUniqueId());
+                positionById[id] = noPosition;
+                positionsValid = min(positionsValid, static_cast<size_t>(kept - animals.begin()));
+                bySpecies.erase(id);
+                byBirth.erase(id);
+                journalUpdate(*it, false);
+                continue;
+            }
+            if (kept != it) *kept = *it;
+            ++kept;
+        }
+        size_t removed = static_cast<size_t>(animals.end() - kept);
+        animals.erase(kept, animals.end());
+        return removed;
+    }
+
+    /**
+     * @brief Находит животное по идентификатору.
+     * @param id Идентификатор животного.
+     * @return Указатель на запись или nullptr, если животного нет в зоопарке.
+     */
+    Animal* findAnimal(uint32_t id) { return const_cast<Animal*>(as_const(*this).findAnimal(id)); }
+
+    /**
+     * @brief Находит животное по идентификатору (для чтения).
+     * @param id Идентификатор животного.
+     * @return Указатель на запись или nullptr, если животного нет в зоопарке.
+     */
+    const Animal* findAnimal(uint32_t id) const {
+        syncPositions();
+        if (id >= positionById.size() || positionById[id] == noPosition) return nullptr;
+        return &animals[positionById[id]];
+    }
+
+    /**
+     * @brief Пересчитывает позиции записей, сдвинутых удалениями.
+     */
+    void syncPositions() const {
+        for (; positionsValid < animals.size(); ++positionsValid) {
+            positionById[static_cast<uint32_t>(animals[positionsValid].getUniqueId())] = static_cast<uint32_t>(positionsValid);
+        }
+    }
+
+    /**
+     * @brief Перебирает группы индекса byBirth, в которых могут быть животные старше указанного возраста.
+     * @param age Возраст.
+     * @param visit Функция, получающая ключ и группу; возвращает ложь, чтобы остановить перебор.
+     */
+    template<class Visit>
+    void forEachOlderThan(int age, Visit&& visit) const {
+        byBirth.forEachGroup(numeric_limits<int32_t>::min(), birthBucket(max(day - age - 1, -65536)), visit);
+    }
+
+    /**
+     * @brief Перебирает животных, среди которых могут быть подходящие под запрос, в порядке поступления.
+     *
+     * Кандидаты берутся из самого узкого подходящего индекса: вольера, вида или диапазона периодов
+     * рождения; без фильтров по ним перебираются все животные. Группы индексов вида и возраста
+     * не упорядочены, поэтому их кандидаты сортируются по позиции записи.
+     * @param query Запрос.
+     * @param visit Функция, получающая животное; возвращает ложь, чтобы остановить перебор.
+     */
+    template<class Visit>
+    void forEachCandidate(const AnimalQuery& query, Visit&& visit) const {
+        const Enclosure* enc = nullptr;
+        size_t best = animals.size();
+        if (query.enclosure) {
+            for (const auto& candidate : enclosures) {
+                if (candidate.getId() == *query.enclosure) enc = &candidate;
+            }
+            if (!enc) return;
+            best = enc->getAnimalIds().size();
+        }
+        const pmr::vector<uint32_t>* speciesGroup = nullptr;
+        if (query.species && bySpecies.group(*query.species).size() < best) {
+            speciesGroup = &bySpecies.group(*query.species);
+            best = speciesGroup->size();
+        }
+        int32_t lowKey = birthBucket(static_cast<int>(max<int64_t>(int64_t(day) - query.maxAge, -65536)));
+        int32_t highKey = birthBucket(static_cast<int>(max<int64_t>(int64_t(day) - query.minAge, -65536)));
+        bool byAge = (query.minAge > 0 || query.maxAge < numeric_limits<int>::max()) && byBirth.count(lowKey, highKey) < best;
+        if (!byAge && !speciesGroup) {
+            if (enc) {
+                for (int id : enc->getAnimalIds()) {
+                    if (!visit(*findAnimal(static_cast<uint32_t>(id)))) return;
+                }
+                return;
+            }
+            for (const auto& animal : animals) {
+                if (!visit(animal)) return;
+            }
+            return;
+        }
+        vector<uint32_t> positions;
+        syncPositions();
+        auto collect = [&](const pmr::vector<uint32_t>& group) {
+            for (uint32_t id : group) positions.push_back(positionById[id]);
+        };
+        if (byAge) {
+            byBirth.forEachGroup(lowKey, highKey, [&](int32_t, const pmr::vector<uint32_t>& group) {
+                collect(group);
+                return true;
+            });
+        }
+        else collect(*speciesGroup);
+        sort(positions.begin(), positions.end());
+        for (uint32_t position : positions) {
+            if (!visit(animals[position])) return;
+        }
+    }
+
+    /**
+     * @brief Выполняет запрос к животным и возвращает одну страницу результатов.
+     *
+     * Без сортировки перебор останавливается, как только страница заполнена и найдено следующее
+     * подходящее животное; с сортировкой упорядочиваются только первые offset + limit результатов.
+     * @param query Запрос.
+     * @param offset Сколько подходящих животных пропустить.
+     * @param limit Размер страницы.
+     * @return Страница результатов.
+     */
+    AnimalPage queryAnimals(const AnimalQuery& query, size_t offset, size_t limit) const {
+        AnimalPage page;
+        if (query.sort == AnimalQuery::SortKey::ARRIVAL) {
+            size_t matched = 0;
+            forEachCandidate(query, [&](const Animal& a) {
+                if (!query.matches(a)) return true;
+                if (matched++ < offset) return true;
+                if (page.ids.size() == limit) {
+                    page.more = true;
+                    return false;
+                }
+                page.ids.push_back(static_cast<uint32_t>(a.getUniqueId()));
+                return true;
+            });
+            return page;
+        }
+        vector<pair<double, uint32_t>> keyed;
+        forEachCandidate(query, [&](const Animal& a) {
+            if (query.matches(a)) keyed.emplace_back(query.descending ? -query.sortValue(a) : query.sortValue(a), a.getUniqueId());
+            return true;
+        });
+        size_t end = min(keyed.size(), offset + limit);
+        if (offset >= end) return page;
+        partial_sort(keyed.begin(), keyed.begin() + static_cast<ptrdiff_t>(end), keyed.end());
+        for (size_t i = offset; i < end; ++i) page.ids.push_back(keyed[i].second);
+        page.more = keyed.size() > end;
+        return page;
+    }
+
+    /**
+     * @brief Выводит краткую строку о животном для списков выбора.
+     * @param out Поток вывода.
+     * @param animal Животное.
+     */
+    void describeBrief(ostream& out, const Animal& animal) const {
+        out << "ID " << animal.getUniqueId() << ". " << speciesName(animal) << " (" << displayName(animal) << ")"
+            << ", Пол: " << (animal.getGender() == Gender::MALE ? "М" : "Ж") << ", Возраст: " << animal.getAgeDays()
+            << ", ID вольера: " << animal.getEnclosureId() << (animal.getIsSick() ? ", болен" : "") << "\n";
+    }
+
+    /**
+     * @brief Выводит полную информацию о животном.
+     * @param out Поток вывода.
+     * @param animal Животное.
+     */
+    void describeFull(ostream& out, const Animal& animal) {
+        out << "ID " << animal.getUniqueId() << ". Вид: " << speciesName(animal) << ", Имя: " << displayName(animal)
+            << ", Возраст: " << animal.getAgeDays() << " дней"
+            << ", Пол: " << (animal.getGender() == Gender::MALE ? "М" : "Ж")
+            << ", Вес: " << animal.getWeight() << " кг"
+            << ", Климат: ";
+        switch (animal.getPreferredClimate()) {
+        case Climate::TROPICAL: out << "Тропический"; break;
+        case Climate::TEMPERATE: out << "Умеренный"; break;
+        case Climate::ARCTIC: out << "Арктический"; break;
+        }
+        out << ", Тип: " << (animal.getType() == AnimalType::HERBIVORE ? "Травоядное" : "Хищник")
+            << ", ID вольера: " << animal.getEnclosureId() << ", Дней с покупки: " << animal.getDaysSincePurchase()
+            << ", Болен: " << (animal.getIsSick() ? "Да" : "Нет");
+        if (animal.getIsBornInZoo()) {
+            auto parents = pedigree.getParentIds(animal.getUniqueId());
+            size_t ancestors = 0;
+            pedigree.forEachAncestor(animal.getUniqueId(), [&ancestors](uint32_t) { ancestors++; });
+            out << ", Родители: " << displayNameById(parents.first) << " и " << displayNameById(parents.second)
+                << ", Предков в родословной: " << ancestors << ", Инбридинг: " << pedigree.getInbreeding(animal.getUniqueId());
+        }
+        out << "\n";
+    }
+
+    /**
+     * @brief Показывает животных постранично с фильтрами и ждет выбора по идентификатору.
+     *
+     * Пустая строка листает страницы, строка с «ключ=значение» задает новый запрос (см. AnimalQuery),
+     * число выбирает животное.
+     * @param io Канал сессии.
+     * @param action Что будет сделано с выбранным животным (начало приглашения).
+     * @param full Выводить полную информацию вместо краткой строки.
+     * @return Идентификатор выбранного животного или 0 при отмене.
+     */
+    Task<uint32_t> pickAnimal(Console& io, string_view action, bool full = false) {
+        ostream& out = io.output();
+        AnimalQuery query;
+        size_t offset = 0;
+        while (true) {
+            AnimalPage page = queryAnimals(query, offset, pageSize);
+            if (page.ids.empty()) out << "Нет подходящих животных.\n";
+            for (uint32_t id : page.ids) {
+                if (full) describeFull(out, *findAnimal(id));
+                else describeBrief(out, *findAnimal(id));
+            }
+            out << action << ": введите ID животного, фильтр (например, вид=Лев пол=ж возраст=5-30 сорт=-возраст), "
+                << (page.more ? "Enter — следующая страница" : "Enter — с начала") << ", 0 — отмена: ";
+            string line = co_await io.readLine();
+            size_t start = line.find_first_not_of(" \t\r");
+            if (start == string::npos) {
+                offset = page.more ? offset + pageSize : 0;
+                continue;
+            }
+            uint32_t id;
+            auto [end, ec] = from_chars(line.data() + start, line.data() + line.size(), id);
+            if (ec == errc() && line.find_first_not_of(" \t\r", static_cast<size_t>(end - line.data())) == string::npos) {
+                if (id == 0 || findAnimal(id)) co_return id;
+                out << "Животного с ID " << id << " нет в зоопарке.\n";
+                continue;
+            }
+            try {
+                query = AnimalQuery::parse(string_view(line).substr(start), species);
+                offset = 0;
+            }
+            catch (const runtime_error& e) {
+                out << e.what() << "\n";
+            }
+        }
+    }
+
+    /**
+     * @struct SlotCursor
+     * @brief Сопоставляет животным при проходе по зоопарку их места в вольерах.
+     *
+     * Животные в вольере занимают места в том же порядке, что и в зоопарке, поэтому место животного —
+     * количество уже пройденных животных того же вольера. Удаленное при проходе животное места не занимает.
+     */
+    struct SlotCursor {
+        pmr::vector<Enclosure*> byId; /**< Вольеры по идентификатору */
+        pmr::vector<size_t> next;     /**< Следующее место в каждом вольере */
+
+        /**
+         * @brief Находит вольер животного.
+         * @param animal Животное.
+         * @return Указатель на вольер или nullptr.
+         */
+        Enclosure* enclosure(const Animal& animal) const {
+            int encId = animal.getEnclosureId();
+            return encId >= 0 && static_cast<size_t>(encId) < byId.size() ? byId[encId] : nullptr;
+        }
+
+        /**
+         * @brief Получает место животного, не продвигая курсор (для удаляемого животного).
+         * @param animal Животное, находящееся в вольере.
+         * @return Место в вольере.
+         */
+        size_t peek(const Animal& animal) const { return next[animal.getEnclosureId()]; }
+
+        /**
+         * @brief Получает место животного и переходит к следующему.
+         * @param animal Животное, находящееся в вольере.
+         * @return Место в вольере.
+         */
+        size_t take(const Animal& animal) { return next[animal.getEnclosureId()]++; }
+    };
+
+    /**
+     * @brief Создает в арене дня курсор мест, установленный на начало всех вольеров.
+     * @return Курсор мест.
+     */
+    SlotCursor slotCursor() {
+        int maxId = -1;
+        for (const auto& enc : enclosures) maxId = max(maxId, enc.getId());
+        size_t size = static_cast<size_t>(maxId + 1);
+        SlotCursor cursor{ pmr::vector<Enclosure*>(size, nullptr, &dayArena), pmr::vector<size_t>(size, 0, &dayArena) };
+        for (auto& enc : enclosures) {
+            if (enc.getId() >= 0) cursor.byId[enc.getId()] = &enc;
+        }
+        return cursor;
+    }
+
+    /**
+     * @brief Лечит больных животных в вольерах работника.
+     *
+     * Число больных в вольерах берется подсчетом битов; если работник может вылечить всех,
+     * признак болезни сбрасывается у вольеров целиком.
+     * @tparam Role Политика роли (задает наибольшее число животных на попечении).
+     * @param worker Работник.
+     * @return Количество вылеченных животных (включая особей стад).
+     */
+    template<class Role>
+    int treat(const Worker& worker) {
+        const auto& encIds = worker.getAssignedEnclosures();
+        auto assigned = [&encIds](int encId) { return find(encIds.begin(), encIds.end(), encId) != encIds.end(); };
+        size_t sick = 0;
+        for (int encId : encIds) {
+            if (const Enclosure* enc = findEnclosure(encId)) sick += enc->countFlag(Enclosure::SICK);
+        }
+        int treated = 0;
+        if (sick > 0 && sick <= static_cast<size_t>(Role::maxAnimals)) {
+            for (int encId : encIds) {
+                if (Enclosure* enc = findEnclosure(encId)) enc->clearFlag(Enclosure::SICK);
+            }
+            for (auto& animal : animals) {
+                if (animal.getIsSick() && assigned(animal.getEnclosureId())) animal.setSick(false);
+            }
+            treated = static_cast<int>(sick);
+        }
+        else if (sick > 0) {
+            SlotCursor cursor = slotCursor();
+            for (auto& animal : animals) {
+                if (treated >= Role::maxAnimals) break;
+                Enclosure* enc = cursor.enclosure(animal);
+                if (!enc) continue;
+                size_t slot = cursor.take(animal);
+                if (animal.getIsSick() && assigned(animal.getEnclosureId())) {
+                    animal.setSick(false);
+                    enc->setFlag(slot, Enclosure::SICK, false);
+                    treated++;
+                }
+            }
+        }
+        for (auto& c : cohorts.getCohorts()) {
+            if (treated >= Role::maxAnimals) break;
+            if (c.sick == 0 || find(encIds.begin(), encIds.end(), c.enclosureId) == encIds.end()) continue;
+            uint64_t cured = min<uint64_t>(c.sick, Role::maxAnimals - treated);
+            c.sick -= cured;
+            treated += static_cast<int>(cured);
+        }
+        return treated;
+    }
+
+    /**
+     * @brief Находит вольер по идентификатору.
+     * @param id Идентификатор вольера.
+     * @return Указатель на вольер или nullptr.
+     */
+    Enclosure* findEnclosure(int id) {
+        for (auto& enc : enclosures) {
+            if (enc.getId() == id) return &enc;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Размещает купленное животное в вольере и списывает его цену.
+     * @param animal Животное с идентификатором и видом этого зоопарка.
+     * @param enclosureId Идентификатор вольера.
+     * @return Истина, если покупка состоялась.
+     */
+    bool acceptAnimal(Animal animal, int enclosureId) {
+        if (day > rules.freePurchaseDays && animalsBoughtToday >= 1) return false;
+        Enclosure* enc = findEnclosure(enclosureId);
+        if (money < animal.getPrice() || !enc || !enc->canAddAnimal(animal)) return false;
+        if (!(populationMode ? reserveCohort() : reserveIndividual())) return false;
+        if (populationMode) {
+            placeInCohort(animal, *enc, animal.getGender(), animal.getAgeDays(), 1);
+        }
+        else {
+            animal.setEnclosureId(enclosureId);
+            enc->addAnimal(animal);
+            appendAnimal(animal);
+            pedigree.addFounder(animal.getUniqueId(), animal.getSpeciesId());
+            // После отмены покупки рынок возвращается с теми же идентификаторами, и узел уже есть в родословной.
+            pedigree.markPresent(animal.getUniqueId());
+            totalAnimals++;
+        }
+        money -= animal.getPrice();
+        animalsBoughtToday++;
+        touch();
+        return true;
+    }
+
+    /**
+     * @brief Оценивает объем памяти, который может понадобиться новой отдельной записи животного.
+     * @return Размер в байтах.
+     */
+    size_t individualReserve() const {
+        size_t bytes = recordReserve();
+        if (animals.size() == animals.capacity()) bytes += max<size_t>(1, animals.capacity() * 2) * sizeof(Animal);
+        if (nextAnimalId >= positionById.capacity()) bytes += max<size_t>(64, positionById.capacity() * 2) * sizeof(uint32_t);
+        bytes += bySpecies.growthReserve(nextAnimalId) + byBirth.growthReserve(nextAnimalId);
+        return bytes;
+    }
+
+    /**
+     * @brief Оценивает объем памяти новой записи без роста вектора животных.
+     * @return Размер в байтах.
+     */
+    size_t recordReserve() const {
+        const size_t slack = 4096; // имя, идентификатор в вольере и мелкие служебные блоки
+        return slack + pedigree.growthReserve();
+    }
+
+    /**
+     * @brief Переводит самое старое животное (кроме указанных) в когорту его вольера.
+     * @param keepA Идентификатор животного, которое нельзя переводить (-1, если нет).
+     * @param keepB Второй такой идентификатор (-1, если нет).
+     * @return Истина, если животное переведено.
+     */
+    bool demoteOldest(int keepA, int keepB) {
+        // Самое старое животное лежит в первой непустой группе периодов рождения; при равном возрасте
+        // выбирается поступившее раньше.
+        auto oldest = animals.end();
+        syncPositions();
+        byBirth.forEachGroup(numeric_limits<int32_t>::min(), numeric_limits<int32_t>::max(),
+            [&](int32_t, const pmr::vector<uint32_t>& group) {
+                for (uint32_t id : group) {
+                    if (static_cast<int>(id) == keepA || static_cast<int>(id) == keepB) continue;
+                    auto it = animals.begin() + positionById[id];
+                    if (oldest == animals.end() || it->getAgeDays() > oldest->getAgeDays() ||
+                        (it->getAgeDays() == oldest->getAgeDays() && it < oldest)) oldest = it;
+                }
+                return oldest == animals.end();
+            });
+        if (oldest == animals.end()) return false;
+        Enclosure* enc = findEnclosure(oldest->getEnclosureId());
+        if (!enc || memory.getBudget().getHeadroom() < cohorts.growthReserve()) return false;
+        *log << displayName(*oldest) << " переведено в стадо: не хватает памяти для отдельных записей.\n";
+        enc->removeAnimal(oldest->getUniqueId());
+        placeInCohort(*oldest, *enc, oldest->getGender(), oldest->getAgeDays(), 1, oldest->getIsSick() ? 1 : 0);
+        forgetAnimal(*oldest);
+        eraseAnimal(oldest);
+        totalAnimals--;
+        touch();
+        return true;
+    }
+
+    /**
+     * @brief Проверяет бюджет памяти перед появлением новой отдельной записи животного.
+     *
+     * Если запаса не хватает, по политике COHORT самое старое животное переводится в когорту,
+     * по политике REFUSE запись не создается. Каждое срабатывание ограничения учитывается в счетчике.
+     * @param keepA Идентификатор животного, которое нельзя переводить в когорту (-1, если нет).
+     * @param keepB Второй такой идентификатор (-1, если нет).
+     * @return Истина, если запись можно создать.
+     */
+    bool reserveIndividual(int keepA = -1, int keepB = -1) {
+        const MemoryBudget& budget = memory.getBudget();
+        if (budget.getHeadroom() >= individualReserve()) return true;
+        cappedEvents++;
+        // Перевод в когорту освобождает место в векторе животных, но не в родословной.
+        if (capPolicy == CapPolicy::COHORT && budget.getHeadroom() >= recordReserve() + cohorts.growthReserve() &&
+            demoteOldest(keepA, keepB)) return true;
+        *log << "Бюджет памяти исчерпан: новое животное не может появиться.\n";
+        return false;
+    }
+
+    /**
+     * @brief Проверяет бюджет памяти перед добавлением животных в когорты.
+     * @return Истина, если когорту можно создать.
+     */
+    bool reserveCohort() {
+        if (memory.getBudget().getHeadroom() >= cohorts.growthReserve()) return true;
+        cappedEvents++;
+        *log << "Бюджет памяти исчерпан: новое стадо не может появиться.\n";
+        return false;
+    }
+
+    /**
+     * @brief Помещает безымянных животных в когорту вольера.
+     * @param prototype Животное-образец (вид, тип, климат, цена).
+     * @param enc Вольер, в который помещаются животные.
+     * @param g Пол животных.
+     * @param ageDays Возраст животных в днях.
+     * @param count Количество животных.
+     * @param sick Сколько из них больны.
+     */
+    void placeInCohort(const Animal& prototype, Enclosure& enc, Gender g, int ageDays, uint64_t count, uint64_t sick = 0) {
+        Cohort c{};
+        c.count = count;
+        c.sick = sick;
+        c.birthDay = day - ageDays;
+        c.price = prototype.getPrice();
+        c.speciesId = prototype.getSpeciesId();
+        c.enclosureId = static_cast<int16_t>(enc.getId());
+        c.type = prototype.getType();
+        c.climate = prototype.getPreferredClimate();
+        c.gender = g;
+        cohorts.add(c);
+        enc.addHerd(count);
+        totalAnimals += static_cast<long long>(count);
+        touch();
+    }
+
+    /**
+     * @brief Сэмплирует число успехов из n испытаний с вероятностью p.
+     * @param n Число испытаний.
+     * @param p Вероятность успеха.
+     * @return Число успехов.
+     */
+    uint64_t binomial(uint64_t n, double p) {
+        if (n == 0 || p <= 0.0) return 0;
+        if (p >= 1.0) return n;
+        return binomial_distribution<uint64_t>(n, p)(rng);
+    }
+
+    /**
+     * @brief Убирает из когорты погибших животных; больные и здоровые гибнут независимо.
+     * @param c Когорта.
+     * @param p Вероятность гибели каждого животного.
+     * @return Количество погибших.
+     */
+    uint64_t cullCohort(Cohort& c, double p) {
+        uint64_t deadSick = binomial(c.sick, p);
+        uint64_t dead = deadSick + binomial(c.count - c.sick, p);
+        if (dead == 0) return 0;
+        c.sick -= deadSick;
+        c.count -= dead;
+        if (Enclosure* enc = findEnclosure(c.enclosureId)) enc->removeHerd(dead);
+        totalAnimals -= static_cast<long long>(dead);
+        return dead;
+    }
+
+public:
+    /**
+     * @brief Создает объект зоопарка.* @param n Название зоопарка.
+     * @param upstream Источник памяти для пулов зоопарка (по умолчанию ресурс по умолчанию процесса).
+     * @param seed Зерно генератора случайных чисел (по умолчанию из random_device).
+     * @param r Правила игры (нужны только для RuntimeRules).
+     */
+    BasicZoo(const string& n, pmr::memory_resource* upstream = pmr::get_default_resource(), uint64_t seed = random_device{}(),
+        const Rules& r = Rules())
+        : memory(upstream), rules(r), rng(seed), batchRng(seed), seed(seed), rollSeed(seed), sampling(), dayArena(upstream), name(n), species(memory.getCatalog()), names(memory.getEntities()),
+        pedigree(memory.getEntities()), money(rules.startingMoney), food(rules.startingFood), popularity(rules.startingPopularity),
+        animals(memory.getEntities()), positionById(memory.getEntities()), positionsValid(0),
+        bySpecies(memory.getEntities()), byBirth(memory.getEntities()), enclosures(memory.getEntities()), workers(memory.getEntities()),
+        loans(memory.getEntities()), cohorts(memory.getEntities()), populationMode(false), day(1), visitors(0), totalAnimals(0), specialVisitorType("None"),
+        specialVisitorCount(0), catalog(memory.getCatalog()), marketAnimals(memory.getEntities()), animalsBoughtToday(0), nextAnimalId(1),
+        capPolicy(CapPolicy::REFUSE), cappedEvents(0), log(&cout), telemetry(nullptr), telemetrySource(0),
+        forecastEnabled(true), ownMarket(true), generation(0), journalValid(false), currentVersion(0), versionGeneration(0),
+        forecast(memory.getEntities()) {
+        // Пол образцов каталога берется из генератора зоопарка, как до появления общего рынка: от этих
+        // десяти бросков зависит вся дальнейшая последовательность, а с ней и результаты прогонов с зерном.
+        auto available = getAvailableAnimals(species);
+        catalog.reserve(available.size());
+        for (const auto& a : available) {
+            catalog.emplace_back(a.getSpeciesId(), a.getAgeDays(), a.getWeight(), a.getPreferredClimate(), a.getPrice(),
+                a.getType(), randomGender());
+        }
+        workers.hire(WorkerType::DIRECTOR, Worker("К.З"));
+        workers.hire(WorkerType::CLEANER, Worker("тринити", vector<int>{1}));
+        workers.hire(WorkerType::VETERINARIAN, Worker("морф"));
+        workers.hire(WorkerType::FEEDER, Worker("диференс", vector<int>{2}));
+        enclosures.emplace_back(1, 5, AnimalType::HERBIVORE, Climate::TEMPERATE, 5 * rules.enclosureSlotUpkeep);
+        refreshMarket();
+    }
+
+    /**
+     * @brief Получает текущие денежные средства.
+     * @return Сумма денег.
+     */
+    double getMoney() const { return money; }
+
+    /**
+     * @brief Получает доступные единицы еды.
+     * @return Единицы еды.
+     */
+    int getFood() const { return food; }
+
+    /**
+     * @brief Получает очки популярности.
+     * @return Очки популярности.
+     */
+    double getPopularity() const { return popularity; }
+
+    /**
+     * @brief Получает текущий день.
+     * @return Текущий день.
+     */
+    int getDay() const { return day; }
+
+    /**
+     * @brief Получает количество посетителей сегодня.
+     * @return Количество посетителей.
+     */
+    int getVisitors() const { return visitors; }
+
+    /**
+     * @brief Получает общее количество животных.
+     * @return Общее количество животных.
+     */
+    long long getTotalAnimals() const { return totalAnimals; }
+
+    /**
+     * @brief Рассчитывает количество еды, необходимое животным на день.
+     * @return Единицы еды (травоядному 1, хищнику 2).
+     */
+    long long dailyFoodDemand() const {
+        long long demand = 0;
+        for (const auto& enc : enclosures) demand += enc.foodDemand();
+        for (const auto& c : cohorts.getCohorts()) {
+            demand += static_cast<long long>(c.count) * ((c.type == AnimalType::HERBIVORE) ? 1 : 2);
+        }
+        return demand;
+    }
+
+    /**
+     * @brief Покупает животное с рынка и размещает его в вольере.
+     * @param marketIndex Индекс животного на рынке.
+     * @param enclosureId Идентификатор вольера.
+     * @return Истина, если покупка состоялась; ложь, если животного нет, не хватает денег, вольер
+     *         не подходит, исчерпан дневной лимит покупок или бюджет памяти.
+     */
+    bool buyAnimal(size_t marketIndex, int enclosureId) {
+        if (marketIndex >= marketAnimals.size() || !acceptAnimal(marketAnimals[marketIndex], enclosureId)) return false;
+        marketAnimals.erase(marketAnimals.begin() + marketIndex);
+        return true;
+    }
+
+    /**
+     * @brief Покупает животное, выставленное вне зоопарка (например, на общем рынке мира).
+     * @param animal Животное; вид и идентификатор переводятся в справочник и нумерацию зоопарка.
+     * @param speciesName Название вида.
+     * @param enclosureId Идентификатор вольера.
+     * @return Истина, если покупка состоялась (условия те же, что у buyAnimal).
+     */
+    bool receiveAnimal(Animal animal, string_view speciesName, int enclosureId) {
+        animal.setSpeciesId(species.intern(speciesName));
+        animal.setUniqueId(nextAnimalId);
+        if (!acceptAnimal(animal, enclosureId)) return false;
+        nextAnimalId++;
+        return true;
+    }
+
+    /**
+     * @brief Продает животное за половину цены.
+     * @param animalId Идентификатор животного.
+     * @return Проданное животное или пустое значение, если такого животного нет.
+     */
+    optional<Animal> sellAnimal(int animalId) {
+        auto it = find_if(animals.begin(), animals.end(), [&](const Animal& a) { return a.getUniqueId() == animalId; });
+        if (it == animals.end()) return nullopt;
+        Animal sold = *it;
+        money += sold.getPrice() / 2;
+        touch();
+        if (Enclosure* enc = findEnclosure(sold.getEnclosureId())) enc->removeAnimal(sold.getUniqueId());
+        eraseAnimal(it);
+        totalAnimals--;
+        forgetAnimal(sold);
+        return sold;
+    }
+
+    /**
+     * @brief Покупает несколько животных одного вида из каталога и размещает их в одном вольере.
+     *
+     * Вид, вольер, свободные места, деньги и дневной лимит покупок проверяются один раз на всю партию;
+     * если партия не проходит проверку целиком, ничего не покупается. Пол животных чередуется, начиная
+     * с самца. Бюджет памяти проверяется для каждой записи, поэтому при его исчерпании партия может
+     * оказаться куплена частично.
+     * @param speciesName Название вида.
+     * @param count Количество животных.
+     * @param enclosureId Идентификатор вольера.
+     * @return Итог покупки.
+     */
+    BatchResult buyAnimals(string_view speciesName, size_t count, int enclosureId) {
+        BatchResult result;
+        auto prototype = find_if(catalog.begin(), catalog.end(), [&](const Animal& a) {
+            return species.getName(a.getSpeciesId()) == speciesName;
+        });
+        Enclosure* enc = findEnclosure(enclosureId);
+        double cost = prototype == catalog.end() ? 0 : static_cast<double>(prototype->getPrice()) * static_cast<double>(count);
+        if (prototype == catalog.end()) result.message = "Вида " + string(speciesName) + " нет в каталоге.";
+        else if (!enc) result.message = "Вольера " + to_string(enclosureId) + " нет.";
+        else if (count == 0) result.message = "Количество должно быть больше нуля.";
+        else if (!enc->canAddHerd(prototype->getType(), prototype->getPreferredClimate(), count)) {
+            result.message = "Вольер " + to_string(enclosureId) + " не подходит или в нем не хватает мест.";
+        }
+        else if (money < cost) result.message = "Не хватает денег: нужно $" + to_string(static_cast<long long>(cost)) + ".";
+        else if (day > rules.freePurchaseDays && animalsBoughtToday + count > 1) {
+            result.message = "Сегодня можно купить не больше одного животного.";
+        }
+        if (!result.message.empty()) return result;
+
+        if (populationMode) {
+            Gender genders[] = { Gender::MALE, Gender::FEMALE };
+            for (uint64_t g = 0; g < 2 && g < count; ++g) {
+                if (!reserveCohort()) break;
+                uint64_t herd = (count + 1 - g) / 2;
+                placeInCohort(*prototype, *enc, genders[g], prototype->getAgeDays(), herd);
+                result.applied += herd;
+            }
+        }
+        else {
+            for (; result.applied < count; ++result.applied) {
+                if (!reserveIndividual()) break;
+                Animal animal(prototype->getSpeciesId(), prototype->getAgeDays(), prototype->getWeight(),
+                    prototype->getPreferredClimate(), prototype->getPrice(), prototype->getType(),
+                    result.applied % 2 ? Gender::FEMALE : Gender::MALE);
+                animal.setUniqueId(nextAnimalId++);
+                animal.setEnclosureId(enclosureId);
+                enc->addAnimal(animal);
+                appendAnimal(animal);
+                pedigree.addFounder(animal.getUniqueId(), animal.getSpeciesId());
+                totalAnimals++;
+            }
+        }
+        result.money = -static_cast<double>(prototype->getPrice()) * static_cast<double>(result.applied);
+        money += result.money;
+        animalsBoughtToday += static_cast<int>(result.applied);
+        touch();
+        result.ok = result.applied > 0;
+        result.message = "Куплено: " + to_string(result.applied) + " × " + string(speciesName) + " в вольер " +
+            to_string(enclosureId) + " за $" + to_string(static_cast<long long>(-result.money)) + ".";
+        return result;
+    }
+
+    /**
+     * @brief Продает за половину цены всех отдельных животных, подходящих под запрос.
+     *
+     * Места в вольерах освобождаются тем же проходом, что и записи зоопарка; стада популяционного
+     * режима не продаются.
+     * @param query Запрос (порядок сортировки не учитывается).
+     * @return Итог продажи.
+     */
+    BatchResult sellAnimals(const AnimalQuery& query) {
+        BatchResult result;
+        SlotCursor cursor = slotCursor();
+        result.applied = eraseAnimalsIf([&](const Animal& animal) {
+            Enclosure* enc = cursor.enclosure(animal);
+            if (!query.matches(animal)) {
+                if (enc) cursor.take(animal);
+                return false;
+            }
+            if (enc) enc->removeSlot(cursor.peek(animal));
+            result.money += animal.getPrice() / 2;
+            forgetAnimal(animal);
+            return true;
+        });
+        money += result.money;
+        totalAnimals -= static_cast<long long>(result.applied);
+        touch();
+        result.ok = true;
+        result.message = "Продано: " + to_string(result.applied) + " за $" + to_string(static_cast<long long>(result.money)) + ".";
+        return result;
+    }
+
+    /**
+     * @brief Заново распределяет вольеры между всеми работниками роли по кругу.
+     *
+     * Вольеры перебираются по порядку, и каждый достается следующему по кругу работнику, которому
+     * позволяют ограничения роли (число вольеров и животных на попечении); если никому не позволяют,
+     * вольер остается без работника этой роли. Прежние назначения работников роли снимаются.
+     * @param type Роль.
+     * @param days Срок назначения в днях.
+     * @return Итог назначения (applied — число вольеров, получивших работника).
+     */
+    BatchResult assignRoundRobin(WorkerType type, int days) {
+        BatchResult result;
+        const RoleInfo& info = WorkerRoster::info(type);
+        size_t staff = 0;
+        workers.forEachCrew([&](auto& crew) {
+            using Role = typename decay_t<decltype(crew)>::RoleType;
+            if (Role::type != type || Role::maxEnclosures == 0 || days < 1) return;
+            auto& members = crew.members;
+            staff = members.size();
+            pmr::vector<size_t> load(members.size(), 0, &dayArena);
+            for (auto& worker : members) {
+                worker.clearAssignedEnclosures();
+                worker.setDaysAssigned(days);
+            }
+            size_t next = 0;
+            for (const auto& enc : enclosures) {
+                size_t here = enc.getAnimalCount();
+                for (size_t tries = 0; tries < members.size(); ++tries) {
+                    size_t w = (next + tries) % members.size();
+                    if (members[w].getAssignedEnclosures().size() >= Role::maxEnclosures) continue;
+                    if (Role::maxAnimals > 0 && load[w] + here > static_cast<size_t>(Role::maxAnimals)) continue;
+                    members[w].assignEnclosure(enc.getId());
+                    load[w] += here;
+                    result.applied++;
+                    next = w + 1;
+                    break;
+                }
+            }
+        });
+        if (info.maxEnclosures == 0) result.message = string(info.title) + " не назначается на вольеры.";
+        else if (days < 1) result.message = "Срок назначения должен быть не меньше дня.";
+        else if (staff == 0) result.message = "Нет работников с должностью " + string(info.title) + ".";
+        else {
+            touch();
+            result.ok = true;
+            result.message = string(info.title) + ": назначено вольеров " + to_string(result.applied) + " из " +
+                to_string(enclosures.size()) + ", работников " + to_string(staff) + ", на " + to_string(days) + " дней.";
+        }
+        return result;
+    }
+
+    /**
+     * @brief Выполняет пакетную команду, записанную строкой.
+     *
+     * Команды: «купить 20 Кролик в 3» (вид можно писать через пробел или подчеркивание), «продать все
+     * болен=да» (после «все» — фильтры AnimalQuery, без них продаются все животные) и «назначить
+     * ветеринаров по кругу 30» (роль: ветеринаров, уборщиков или кормильцев; число дней — по желанию,
+     * по умолчанию 30).
+     * @param line Строка команды.
+     * @return Итог команды.
+     * @throws runtime_error Если команда записана с ошибкой.
+     */
+    BatchResult runCommand(string_view line) {
+        DayArena::Scope scope(dayArena);
+        vector<string_view> tokens;
+        for (size_t pos = 0; pos < line.size();) {
+            size_t start = line.find_first_not_of(" \t\r", pos);
+            if (start == string_view::npos) break;
+            size_t end = min(line.find_first_of(" \t\r", start), line.size());
+            tokens.push_back(line.substr(start, end - start));
+            pos = end;
+        }
+        auto number = [](string_view token, string_view what) {
+            int value = 0;
+            auto [end, ec] = from_chars(token.data(), token.data() + token.size(), value);
+            if (ec != errc() || end != token.data() + token.size() || value < 0) {
+                throw runtime_error("Ожидалось " + string(what) + ": " + string(token) + ".");
+            }
+            return value;
+        };
+        if (tokens.empty()) throw runtime_error("Пустая команда.");
+        if (tokens[0] == "купить") {
+            auto into = find(tokens.begin(), tokens.end(), string_view("в"));
+            if (tokens.size() < 5 || into != tokens.end() - 2 || into - tokens.begin() < 3) {
+                throw runtime_error("Формат: купить <количество> <вид> в <вольер>.");
+            }
+            int count = number(tokens[1], "количество");
+            string name;
+            for (auto it = tokens.begin() + 2; it != into; ++it) name.append(name.empty() ? "" : " ").append(*it);
+            replace(name.begin(), name.end(), '_', ' ');
+            return buyAnimals(name, static_cast<size_t>(count), number(tokens.back(), "номер вольера"));
+        }
+        if (tokens[0] == "продать") {
+            if (tokens.size() < 2 || tokens[1] != "все") throw runtime_error("Формат: продать все [фильтры].");
+            size_t rest = static_cast<size_t>(tokens[1].data() + tokens[1].size() - line.data());
+            return sellAnimals(AnimalQuery::parse(line.substr(rest), species));
+        }
+        if (tokens[0] == "назначить") {
+            if (tokens.size() < 4 || tokens.size() > 5 || tokens[2] != "по" || tokens[3] != "кругу") {
+                throw runtime_error("Формат: назначить <роль> по кругу [дней].");
+            }
+            static constexpr pair<string_view, WorkerType> roles[] = { { "ветеринар", WorkerType::VETERINARIAN },
+                { "уборщ", WorkerType::CLEANER }, { "кормил", WorkerType::FEEDER } };
+            auto role = find_if(begin(roles), end(roles), [&](const auto& r) { return tokens[1].starts_with(r.first); });
+            if (role == end(roles)) throw runtime_error("Неизвестная роль: " + string(tokens[1]) + ".");
+            return assignRoundRobin(role->second, tokens.size() == 5 ? number(tokens[4], "число дней") : 30);
+        }
+        throw runtime_error("Неизвестная команда: " + string(tokens[0]) + ".");
+    }
+
+    /**
+     * @brief Снимает версию текущего состояния.
+     *
+     * Журнал животных строится заново только при первом снимке дня (nextDay сбрасывает его, чтобы
+     * пакетные прогоны без снимков его не вели); дальше версия стоит O(log n) на каждое изменение
+     * животного и копирование небольших списков.
+     * @return Версия состояния.
+     */
+    Snapshot snapshot() {
+        if (!journalValid) {
+            vector<typename Snapshot::Entry> entries;
+            entries.reserve(animals.size());
+            journalSlot.assign(nextAnimalId, noPosition);
+            for (const auto& animal : animals) {
+                journalSlot[animal.getUniqueId()] = static_cast<uint32_t>(entries.size());
+                entries.push_back(journalEntry(animal));
+            }
+            journal = PersistentVector<typename Snapshot::Entry>::build(entries.begin(), entries.end());
+            journalValid = true;
+        }
+        Snapshot s;
+        s.animals = journal;
+        for (const auto& enc : enclosures) {
+            s.enclosures.emplace_back(enc.getId(), enc.getCapacity(), enc.getAnimalType(), enc.getClimate(), enc.getDailyCost());
+            s.enclosures.back().addHerd(enc.getHerdSize());
+        }
+        for (size_t i = 0; i < workers.size(); ++i) {
+            auto entry = workers.at(i);
+            s.workers.emplace_back(entry.role.type, entry.worker);
+        }
+        s.loans.assign(loans.begin(), loans.end());
+        s.cohorts.assign(cohorts.getCohorts().begin(), cohorts.getCohorts().end());
+        s.market.assign(marketAnimals.begin(), marketAnimals.end());
+        s.rng = rng;
+        s.money = money;
+        s.food = food;
+        s.popularity = popularity;
+        s.day = day;
+        s.visitors = visitors;
+        s.totalAnimals = totalAnimals;
+        s.animalsBoughtToday = animalsBoughtToday;
+        s.specialVisitorType = specialVisitorType;
+        s.specialVisitorCount = specialVisitorCount;
+        return s;
+    }
+
+    /**
+     * @brief Возвращает зоопарк к версии.
+     *
+     * Записи животных, вольеры, индексы и позиции перестраиваются по версии за O(n); журнал версии
+     * становится текущим журналом, поэтому следующие снимки снова делят с ней узлы. nextAnimalId не
+     * откатывается, поэтому новые животные не получают идентификаторы отмененных. Исключение — рынок: он
+     * возвращается вместе с версией, и купленное заново животное рынка сохраняет прежний идентификатор
+     * (acceptAnimal снова отмечает его узел родословной как присутствующий).
+     * @param s Версия, снятая этим зоопарком.
+     */
+    void restore(const Snapshot& s) {
+        for (const auto& animal : animals) forgetAnimal(animal);
+        animals.clear();
+        positionById.assign(positionById.size(), noPosition);
+        positionsValid = 0;
+        bySpecies.clear();
+        byBirth.clear();
+        day = s.day;
+        enclosures.clear();
+        for (const auto& enc : s.enclosures) enclosures.push_back(enc);
+        journalValid = false;
+        journalSlot.assign(nextAnimalId, noPosition);
+        SlotCursor cursor = slotCursor();
+        for (size_t i = 0; i < s.animals.size(); ++i) {
+            const typename Snapshot::Entry& entry = s.animals[i];
+            if (!entry.present) continue;
+            const Animal& animal = entry.animal;
+            appendAnimal(animal);
+            if (!entry.name.empty()) names.set(animal.getUniqueId(), entry.name);
+            pedigree.markPresent(animal.getUniqueId());
+            if (Enclosure* enc = cursor.enclosure(animal)) enc->addAnimal(animal);
+            journalSlot[animal.getUniqueId()] = static_cast<uint32_t>(i);
+        }
+        journal = s.animals;
+        journalValid = true;
+        while (!workers.empty()) workers.erase(workers.size() - 1);
+        for (const auto& [type, worker] : s.workers) workers.hire(type, worker);
+        loans.assign(s.loans.begin(), s.loans.end());
+        cohorts.clear();
+        for (const auto& c : s.cohorts) cohorts.add(c);
+        marketAnimals.assign(s.market.begin(), s.market.end());
+        rng = s.rng;
+        money = s.money;
+        food = s.food;
+        popularity = s.popularity;
+        visitors = s.visitors;
+        totalAnimals = s.totalAnimals;
+        animalsBoughtToday = s.animalsBoughtToday;
+        specialVisitorType = s.specialVisitorType;
+        specialVisitorCount = s.specialVisitorCount;
+        touch();
+    }
+
+    /**
+     * @brief Запоминает текущее состояние как версию для отмены, если оно изменилось с прошлой версии.
+     *
+     * Отмененные версии после текущей отбрасываются; хранится не больше maxVersions версий.
+     */
+    void checkpoint() {
+        if (!versions.empty() && versionGeneration == generation) return;
+        if (!versions.empty()) versions.erase(versions.begin() + static_cast<ptrdiff_t>(currentVersion) + 1, versions.end());
+        if (versions.size() == maxVersions) versions.erase(versions.begin());
+        versions.push_back(make_shared<const Snapshot>(snapshot()));
+        currentVersion = versions.size() - 1;
+        versionGeneration = generation;
+    }
+
+    /**
+     * @brief Отменяет последнее действие текущего дня.
+     * @return Ложь, если отменять нечего.
+     */
+    bool undo() {
+        checkpoint();
+        if (currentVersion == 0) return false;
+        restore(*versions[--currentVersion]);
+        versionGeneration = generation;
+        return true;
+    }
+
+    /**
+     * @brief Повторяет отмененное действие.
+     * @return Ложь, если повторять нечего.
+     */
+    bool redo() {
+        if (versions.empty() || versionGeneration != generation || currentVersion + 1 == versions.size()) return false;
+        restore(*versions[++currentVersion]);
+        versionGeneration = generation;
+        return true;
+    }
+
+    /**
+     * @brief Получает название вида животного.
+     * @param animal Животное этого зоопарка.
+     * @return Название вида.
+     */
+    string_view getSpeciesName(const Animal& animal) const { return speciesName(animal); }
+
+    /**
+     * @brief Рассчитывает ежедневные расходы на зарплаты и содержание вольеров.
+     * @return Сумма расходов.
+     */
+    double getDailyCosts() const {
+        double costs = workers.payroll();
+        for (const auto& enc : enclosures) costs += enc.getDailyCost();
+        return costs;
+    }
+
+    /**
+     * @brief Включает или выключает собственный рынок зоопарка.
+     * @param enabled Ложь, если зоопарк покупает животных на общем рынке мира.
+     */
+    void setOwnMarket(bool enabled) {
+        ownMarket = enabled;
+        if (!enabled) marketAnimals.clear();
+    }
+
+    /**
+     * @brief Покупает еду.
+     * @param amount Количество единиц еды (цена единицы — Rules::foodPrice).
+     * @return Истина, если денег хватило.
+     */
+    bool buyFood(int amount) {
+        if (amount < 0 || money < static_cast<double>(amount) * rules.foodPrice) return false;
+        food += amount;
+        money -= static_cast<double>(amount) * rules.foodPrice;
+        touch();
+        return true;
+    }
+
+    /**
+     * @brief Выполняет действия дня без участия игрока (для пакетных прогонов).
+     *
+     * Докупает еду на два дня вперед и покупает самое дешевое животное рынка, для которого есть
+     * подходящий вольер, если после покупки остается запас денег на три дня расходов.
+     */
+    void autopilotDay() {
+        long long shortfall = 2 * dailyFoodDemand() - food;
+        if (shortfall > 0) buyFood(static_cast<int>(min<long long>(shortfall, numeric_limits<int>::max() / 2)));
+
+        double dailyCosts = getDailyCosts();
+        size_t cheapest = marketAnimals.size();
+        for (size_t i = 0; i < marketAnimals.size(); ++i) {
+            if (cheapest == marketAnimals.size() || marketAnimals[i].getPrice() < marketAnimals[cheapest].getPrice()) cheapest = i;
+        }
+        if (cheapest == marketAnimals.size() || money - marketAnimals[cheapest].getPrice() < 3 * dailyCosts) return;
+        for (const auto& enc : enclosures) {
+            if (enc.canAddAnimal(marketAnimals[cheapest])) {
+                buyAnimal(cheapest, enc.getId());
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Задает поток сообщений о событиях дня (смерти, погашение кредитов, ограничения памяти).
+     * @param out Поток вывода; поток без буфера подавляет сообщения.
+     */
+    void setLog(ostream& out) { log = &out; }
+
+    /**
+     * @brief Подключает телеметрию.
+     * @param writer Писатель телеметрии (nullptr — выключить); должен жить дольше зоопарка.
+     * @param source Номер зоопарка в событиях.
+     */
+    void setTelemetry(TelemetryWriter* writer, uint32_t source = 0) {
+        telemetry = writer;
+        telemetrySource = source;
+    }
+
+    /**
+     * @brief Включает или выключает фоновый расчет следующего дня.
+     *
+     * В пакетных прогонах, где зоопарки сами выполняются в пуле потоков, дополнительный поток
+     * на каждый зоопарк только мешает; результаты дня от этого не меняются.
+     * @param enabled Истина, чтобы рассчитывать следующий день в фоне.
+     */
+    void setBackgroundForecast(bool enabled) {
+        forecastEnabled = enabled;
+        if (!enabled) forecast.discard();
+    }
+
+    /**
+     * @brief Задает преобразование бросков для пакетного прогона (задается до первого дня).
+     * @param s Выборка бросков.
+     */
+    void setSampling(const RollSampling& s) {
+        sampling = s;
+        rollSeed = s.rollSeed.value_or(seed);
+    }
+
+    /**
+     * @brief Задает бюджет памяти хранилищ сущностей.
+     * @param bytes Лимит в байтах (0 — без ограничения).
+     * @param policy Поведение при исчерпании бюджета.
+     */
+    void setMemoryBudget(size_t bytes, CapPolicy policy = CapPolicy::REFUSE) {
+        memory.getBudget().setLimit(bytes);
+        capPolicy = policy;
+    }
+
+    /**
+     * @brief Получает объем памяти, занятой сущностями.
+     * @return Байты.
+     */
+    size_t getMemoryUsed() const { return memory.getBudget().getUsed(); }
+
+    /**
+     * @brief Получает число срабатываний ограничения памяти.
+     * @return Количество отказов и переводов в когорты из-за бюджета.
+     */
+    long long getCappedEvents() const { return cappedEvents; }
+
+    /**
+     * @brief Включает или выключает популяционный режим.
+     * @param enabled Истина, чтобы покупаемые животные попадали в когорты.
+     */
+    void setPopulationMode(bool enabled) { populationMode = enabled; }
+
+    /**
+     * @brief Проверяет, включен ли популяционный режим.
+     * @return Истина, если животные хранятся когортами.
+     */
+    bool getPopulationMode() const { return populationMode; }
+
+    /**
+     * @brief Получает когорты безымянных животных.
+     * @return Ссылка на хранилище когорт.
+     */
+    const CohortStore& getCohorts() const { return cohorts; }
+
+    /**
+     * @brief Заселяет в вольер стадо безымянных животных вида из каталога.
+     * @param speciesName Название вида.
+     * @param enclosureId Идентификатор вольера.
+     * @param g Пол животных.
+     * @param ageDays Возраст животных в днях.
+     * @param count Количество животных.
+     * @return Истина, если стадо размещено; ложь, если вид неизвестен или вольер не подходит.
+     */
+    bool addHerd(string_view speciesName, int enclosureId, Gender g, int ageDays, uint64_t count) {
+        auto it = find_if(catalog.begin(), catalog.end(), [&](const Animal& a) {
+            return species.getName(a.getSpeciesId()) == speciesName;
+        });
+        Enclosure* enc = findEnclosure(enclosureId);
+        if (it == catalog.end() || !enc || count == 0 ||
+            !enc->canAddHerd(it->getType(), it->getPreferredClimate(), count) || !reserveCohort()) return false;
+        placeInCohort(*it, *enc, g, ageDays, count);
+        return true;
+    }
+
+    /**
+     * @brief Получает список животных.
+     * @return Ссылка на вектор животных.
+     */
+    const pmr::vector<Animal>& getAnimals() const { return animals; }
+
+    /**
+     * @brief Получает животных, выставленных сегодня на рынке зоопарка.
+     * @return Ссылка на вектор животных рынка.
+     */
+    const pmr::vector<Animal>& getMarket() const { return marketAnimals; }
+
+    /**
+     * @brief Получает список вольеров.
+     * @return Ссылка на вектор вольеров.
+     */
+    const pmr::vector<Enclosure>& getEnclosures() const { return enclosures; }
+
+    /**
+     * @brief Получает список работников.
+     * @return Ссылка на работников по ролям.
+     */
+    const WorkerRoster& getWorkers() const { return workers; }
+
+    /**
+     * @brief Отображает текущий статус зоопарка.
+     * @param out Поток вывода.
+     */
+    void displayStatus(ostream& out = cout) const {
+        out << "\n--- Статус зоопарка \"" << name << "\" (День " << day << ") ---\n";
+        out << "Деньги: $" << money << endl;
+        out << "Еда: " << food << " единиц" << endl;
+        out << "Популярность: " << popularity << endl;
+        out << "Всего животных: " << totalAnimals << endl;
+        out << "Посетителей сегодня: " << visitors << endl;
+        if (specialVisitorType != "None") {
+            out << "Особые гости: " << specialVisitorCount << " " << (specialVisitorType == "Celebrity" ? "Знаменитостей" : "Фотографов") << endl;
+        }
+        out << "Работников: " << workers.size() << endl;
+        out << "Вольеров: " << enclosures.size() << endl;
+        const MemoryBudget& budget = memory.getBudget();
+        if (budget.getLimit() > 0) {
+            out << "Память: " << budget.getUsed() / 1024 << " / " << budget.getLimit() / 1024 << " КиБ"
+                << ", ограничений: " << cappedEvents << endl;
+        }
+    }
+
+    /**
+     * @brief Получает поколение изменений зоопарка.
+     * @return Число, которое растет при каждом изменении состояния.
+     */
+    uint64_t getGeneration() const { return generation; }
+
+    /**
+     * @brief Получает сводку состояния; она перестраивается, только если зоопарк изменился.
+     * @return Ссылка на сводку (действительна до следующего изменения зоопарка).
+     */
+    const StatusSummary& getStatus() const {
+        if (!statusCache || statusCache->generation != generation) statusCache = buildStatus();
+        return *statusCache;
+    }
+
+    /**
+     * @brief Выводит подробный отчет с изменениями со времени прошлого отчета.
+     * @param out Поток вывода.
+     */
+    void displayReport(ostream& out = cout) {
+        const StatusSummary& now = getStatus();
+        const StatusSummary* before = lastReport ? &*lastReport : nullptr;
+        auto delta = [&out](double change) {
+            if (change > 0) out << " (+" << change << ")";
+            else if (change < 0) out << " (" << change << ")";
+        };
+        out << "\n--- Подробный отчет (День " << now.day << ") ---\n";
+        if (before) out << "Изменения — со дня " << before->day << ".\n";
+        out << "Деньги: $" << now.money;
+        if (before) delta(now.money - before->money);
+        out << "\nЕда: " << now.food << " единиц, нужно в день: " << now.foodDemand;
+        if (before) delta(now.food - before->food);
+        out << "\nПопулярность: " << now.popularity;
+        if (before) delta(now.popularity - before->popularity);
+        out << "\nЖивотных: " << now.animals << ", больных: " << now.sick << ", без ветеринара: " << now.sickUntreated;
+        if (before) delta(static_cast<double>(now.sick - before->sick));
+        out << "\nСтарше " << rules.oldAgeDays << " дней: " << now.elderly;
+        if (before) delta(static_cast<double>(now.elderly - before->elderly));
+        out << "\n";
+        if (!now.species.empty()) {
+            out << "По видам:";
+            for (size_t i = 0; i < now.species.size(); ++i) {
+                out << (i ? ", " : " ") << now.species[i].name << " " << now.species[i].animals;
+            }
+            out << "\n";
+        }
+        for (const auto& line : now.enclosures) {
+            out << "Вольер " << line.id << ": " << line.animals << "/" << line.capacity;
+            const StatusSummary::EnclosureLine* old = nullptr;
+            if (before) {
+                for (const auto& candidate : before->enclosures) {
+                    if (candidate.id == line.id) old = &candidate;
+                }
+            }
+            if (old) delta(static_cast<double>(line.animals) - static_cast<double>(old->animals));
+            else if (before) out << " (новый)";
+            out << ", больных: " << line.sick;
+            if (old) delta(static_cast<double>(line.sick) - static_cast<double>(old->sick));
+            out << (line.hasVeterinarian ? "" : ", нет ветеринара") << "\n";
+        }
+        for (const auto& role : now.roles) {
+            const RoleInfo& info = WorkerRoster::info(role.type);
+            out << info.title << ": " << role.workers;
+            if (info.maxEnclosures > 0) out << ", вольеров под присмотром: " << role.covered << "/" << now.enclosures.size();
+            out << "\n";
+        }
+        out << "Кредитов: " << now.loans << ", платеж в конце дня: $" << now.loanPayments << ", долг: $" << now.debt;
+        if (before) delta(now.debt - before->debt);
+        out << "\n";
+        lastReport = now;
+    }
+
+    /**
+     * @brief Возвращает список животных, доступных для покупки.
+     * @param registry Справочник, в котором регистрируются виды.
+     * @return Вектор доступных животных (пол задается при выставлении на рынок).
+     */
+    static vector<Animal> getAvailableAnimals(SpeciesRegistry& registry) {
+        return {
+            {registry.intern("Олень"), 10, 200, Climate::TEMPERATE, 150, AnimalType::HERBIVORE, Gender::MALE},
+            {registry.intern("Слон"), 15, 6000, Climate::TROPICAL, 350, AnimalType::HERBIVORE, Gender::MALE},
+            {registry.intern("Жираф"), 12, 1800, Climate::TROPICAL, 300, AnimalType::HERBIVORE, Gender::MALE},
+            {registry.intern("Зебра"), 8, 400, Climate::TROPICAL, 200, AnimalType::HERBIVORE, Gender::MALE},
+            {registry.intern("Кролик"), 3, 5, Climate::TEMPERATE, 100, AnimalType::HERBIVORE, Gender::MALE},
+            {registry.intern("Лев"), 10, 300, Climate::TROPICAL, 400, AnimalType::CARNIVORE, Gender::MALE},{registry.intern("Волк"), 7, 150, Climate::TEMPERATE, 250, AnimalType::CARNIVORE, Gender::MALE},
+            {registry.intern("Белый медведь"), 14, 800, Climate::ARCTIC, 450, AnimalType::CARNIVORE, Gender::MALE},
+            {registry.intern("Тигр"), 9, 350, Climate::TROPICAL, 350, AnimalType::CARNIVORE, Gender::MALE},
+            {registry.intern("Лисица"), 5, 100, Climate::TEMPERATE, 200, AnimalType::CARNIVORE, Gender::MALE}
+        };
+    }
+
+    /**
+     * @brief Управляет операциями с животными (покупка, продажа, переименование и т.д.).
+     * @param io Канал сессии.
+     */
+    Task<> manageAnimals(Console& io) {
+        ostream& out = io.output();
+        while (true) {
+            DayArena::Scope scope(dayArena);
+            pmr::string prompt(&dayArena);
+            prompt.append("\nУправление животными:\n"
+                "1. Купить животное\n"
+                "2. Продать животное\n"
+                "3. Просмотреть информацию о животных\n"
+                "4. Переименовать животное\n"
+                "5. Обновить рынок животных ($").append(to_string(rules.marketRefreshCost)).append(")\n"
+                "6. Назад\n"
+                "Выберите действие: ");
+            int choice = co_await readNumber(io, prompt, 1, 6);
+            if (choice == 1) {
+                if (day > rules.freePurchaseDays && animalsBoughtToday >= 1) {
+                    out << "После " << rules.freePurchaseDays << "-го дня можно купить только одно животное в день.\n";
+                    continue;
+                }
+                if (marketAnimals.empty()) {
+                    out << "Рынок пуст. Обновите рынок.\n";
+                    continue;
+                }
+                out << "\nДоступные животные для покупки:\n";
+                for (size_t i = 0; i < marketAnimals.size(); ++i) {
+                    out << i + 1 << ". " << speciesName(marketAnimals[i])
+                        << " (" << displayName(marketAnimals[i]) << "), Цена: $" << marketAnimals[i].getPrice()
+                        << ", Пол: " << (marketAnimals[i].getGender() == Gender::MALE ? "М" : "Ж")
+                        << ", Климат: ";
+                    switch (marketAnimals[i].getPreferredClimate()) {
+                    case Climate::TROPICAL: out << "Тропический"; break;
+                    case Climate::TEMPERATE: out << "Умеренный"; break;
+                    case Climate::ARCTIC: out << "Арктический"; break;
+                    }
+                    out << ", Тип: " << (marketAnimals[i].getType() == AnimalType::HERBIVORE ? "Травоядное" : "Хищник") << "\n";
+                }
+                int animalChoice = co_await readNumber(io, choicePrompt("Выберите животное для покупки", marketAnimals.size()), 0, marketAnimals.size());
+                if (animalChoice >= 1 && animalChoice <= static_cast<int>(marketAnimals.size())) {
+                    Animal selected = marketAnimals[animalChoice - 1];
+                    if (money >= selected.getPrice()) {
+                        out << "Выберите вольер (ID) для " << displayName(selected) << ":\n";
+                        bool validEnclosure = false;
+                        pmr::vector<int> validEnclosureIds(&dayArena);
+                        for (const auto& enc : enclosures) {
+                            if (enc.canAddAnimal(selected)) {
+                                out << "ID " << enc.getId() << " (" << enc.getAnimalCount() << "/" << enc.getCapacity() << " животных)\n";
+                                validEnclosureIds.push_back(enc.getId());
+                                validEnclosure = true;
+                            }
+                        }
+                        if (!validEnclosure) {
+                            out << "Нет подходящих вольеров для этого животного.\n";
+                            continue;
+                        }
+                        int encId = co_await readNumber(io, "Введите ID вольера: ", 1, enclosures.back().getId());
+                        const Enclosure* enc = findEnclosure(encId);
+                        if (!enc || !enc->canAddAnimal(selected)) out << "Неверный ID вольера или неподходящий вольер.\n";
+                        else if (buyAnimal(animalChoice - 1, encId)) {
+                            out << displayName(selected) << " куплено и размещено в вольере " << encId << ".\n";
+                        }
+                    }
+                    else out << "Недостаточно денег!\n";
+                }
+            }
+            else if (choice == 2) {
+                if (animals.empty()) {
+                    out << "Нет животных для продажи.\n";
+                    continue;
+                }
+                uint32_t sellId = co_await pickAnimal(io, "Продажа");
+                if (const Animal* sold = findAnimal(sellId)) {
+                    out << displayName(*sold) << " продано за $" << sold->getPrice() / 2 << ".\n";
+                    sellAnimal(static_cast<int>(sellId));
+                }
+            }
+            else if (choice == 3) {
+                if (animals.empty() && cohorts.empty()) {
+                    out << "В зоопарке нет животных.\n";
+                    continue;
+                }
+                out << "\nИнформация о животных:\n";
+                for (const auto& c : cohorts.getCohorts()) {
+                    out << "Стадо: " << species.getName(c.speciesId) << ", Особей: " << c.count
+                        << ", Больных: " << c.sick << ", Возраст: " << (day - c.birthDay) << " дней"
+                        << ", Пол: " << (c.gender == Gender::MALE ? "М" : "Ж")
+                        << ", ID вольера: " << c.enclosureId << "\n";
+                }
+                if (!animals.empty()) {
+                    if (const Animal* chosen = findAnimal(co_await pickAnimal(io, "Просмотр", true))) describeFull(out, *chosen);
+                }
+            }
+            else if (choice == 4) {
+                if (animals.empty()) {
+                    out << "В зоопарке нет животных.\n";
+                    continue;
+                }
+                if (Animal* renamed = findAnimal(co_await pickAnimal(io, "Переименование"))) {
+                    pmr::string newName(&dayArena);
+                    out << "Введите новое имя для " << displayName(*renamed) << ": ";
+                    newName.assign(co_await io.readLine());
+                    if (!newName.empty()) {
+                        setDisplayName(*renamed, newName);
+                        touch();
+                        out << "Животное переименовано в " << newName << ".\n";
+                    }
+                    else out << "Имя не может быть пустым.\n";
+                }
+            }
+            else if (choice == 5) {
+                if (money >= rules.marketRefreshCost) {
+                    money -= rules.marketRefreshCost;
+                    refreshMarket();
+                    touch();
+                    out << "Рынок животных обновлён за $" << rules.marketRefreshCost << ".\n";
+                }
+                else out << "Недостаточно денег для обновления рынка.\n";
+            }
+            else if (choice == 6) break;
+        }
+    }
+
+    /**
+     * @brief Управляет операциями с работниками (найм, увольнение, назначение на вольеры).
+     * @param io Канал сессии.
+     */
+    Task<> manageWorkers(Console& io) {
+        ostream& out = io.output();
+        while (true) {
+            DayArena::Scope scope(dayArena);
+            const char* prompt = "\nУправление работниками:\n"
+                "1. Нанять работника\n"
+                "2. Просмотреть работников\n"
+                "3. Уволить работника\n"
+                "4. Назначить работника на вольер\n"
+                "5. Назад\n"
+                "Выберите действие: ";
+            int choice = co_await readNumber(io, prompt, 1, 5);
+            if (choice == 1) {
+                pmr::string name(&dayArena);
+                while (true) {
+                    out << "Введите имя работника: ";
+                    name.assign(co_await io.readLine());
+                    if (!name.empty()) break;
+                    out << "Имя работника не может быть пустым. Попробуйте снова.\n";
+                }
+                out << "Выберите должность:\n";
+                out << "1. Ветеринар (до 20 животных)\n";
+                out << "2. Уборщик (1 вольер)\n";
+                out << "3. Кормильщик (до 2 вольеров)\n";
+                int posChoice = co_await readNumber(io, "Выберите должность (1-3): ", 1, 3);
+                static constexpr WorkerType hireable[] = { WorkerType::VETERINARIAN, WorkerType::CLEANER, WorkerType::FEEDER };
+                WorkerType position = hireable[posChoice - 1];
+                const RoleInfo& role = WorkerRoster::info(position);
+                Worker newWorker(allocator_arg, &dayArena, name);
+                out << name << " нанят как " << role.title << ".\n";
+                if (enclosures.empty()) {
+                    out << "Нет вольеров для назначения.\n";
+                }
+                else {
+                    if (position == WorkerType::CLEANER) {
+                        out << "Назначьте 1 вольер для уборщика:\n";
+                        for (const auto& enc : enclosures) {
+                            out << "ID " << enc.getId() << " (" << enc.getAnimalCount() << "/" << enc.getCapacity() << " животных)\n";
+                        }
+                        int encId = co_await readNumber(io, "Введите ID вольера: ", 1, enclosures.back().getId());
+                        bool valid = false;
+                        for (const auto& enc : enclosures) {
+                            if (enc.getId() == encId) {
+                                newWorker.assignEnclosure(encId);
+                                valid = true;
+                                break;
+                            }
+                        }
+                        if (!valid) out << "Неверный ID вольера. Назначение отменено.\n";
+                    }
+                    else if (position == WorkerType::FEEDER) {
+                        out << "Назначьте до " << role.maxEnclosures << " вольеров для кормильца (введите ID или 0 для завершения):\n";
+                        for (size_t i = 0; i < role.maxEnclosures; ++i) {
+                            for (const auto& enc : enclosures) {
+                                out << "ID " << enc.getId() << " (" << enc.getAnimalCount() << "/" << enc.getCapacity() << " животных)\n";
+                            }
+                            int encId = co_await readNumber(io, "Введите ID вольера (0 для завершения): ", 0, enclosures.back().getId());
+                            if (encId == 0) break;
+                            bool valid = false;
+                            for (const auto& enc : enclosures) {
+                                if (enc.getId() == encId) {
+                                    newWorker.assignEnclosure(encId);
+                                    valid = true;
+                                    break;
+                                }
+                            }
+                            if (!valid) out << "Неверный ID вольера.\n";
+                        }
+                    }
+                    else if (position == WorkerType::VETERINARIAN) {
+                        int totalAnimalsAssigned = 0;
+                        out << "Назначайте вольеры для ветеринара (до " << role.maxAnimals << " животных). Введите ID или 0 для завершения:\n";
+                        while (true) {
+                            for (const auto& enc : enclosures) {
+                                out << "ID " << enc.getId() << " (" << enc.getAnimalCount() << "/" << enc.getCapacity() << " животных)\n";
+                            }
+                            int encId = co_await readNumber(io, "Введите ID вольера (0 для завершения): ", 0, enclosures.back().getId());
+                            if (encId == 0) break;
+                            bool valid = false;
+                            for (const auto& enc : enclosures) {
+                                if (enc.getId() == encId) {
+                                    int animalCount = enc.getAnimalCount();
+                                    if (totalAnimalsAssigned + animalCount > role.maxAnimals) {
+                                        out << "Превышен лимит в " << role.maxAnimals << " животных.\n";
+                                    }
+                                    else {
+                                        newWorker.assignEnclosure(encId);
+                                        totalAnimalsAssigned += animalCount;
+                                        out << "Вольер " << encId << " назначен. Всего животных: " << totalAnimalsAssigned << "\n";
+                                    }
+                                    valid = true;
+                                    break;
+                                }
+                            }
+                            if (!valid) out << "Неверный ID вольера.\n";
+                        }
+                    }
+                }
+                workers.hire(position, std::move(newWorker));
+                touch();
+            }
+            else if (choice == 2) {
+                if (workers.empty()) {
+                    out << "В зоопарке нет работников.\n";
+                    continue;
+                }
+                out << "\nИнформация о работниках:\n";
+                for (size_t i = 0; i < workers.size(); ++i) {
+                    auto [worker, role] = workers.at(i);
+                    out << i + 1 << ". Имя: " << worker.getName()
+                        << ", Должность: " << role.title
+                        << ", Зарплата: $" << role.salary
+                        << ", Дней проработано: " << worker.getDaysWorked();
+                    if (role.maxAnimals > 0) {
+                        out << ", Управляемых животных: " << role.maxAnimals;
+                    }
+                    out << ", Вольеры: ";
+                    const auto& encIds = worker.getAssignedEnclosures();
+                    if (encIds.empty()) out << "Нет";
+                    else {
+                        for (size_t j = 0; j < encIds.size(); ++j) {
+                            out << encIds[j];
+                            if (j < encIds.size() - 1) out << ", ";
+                        }
+                    }
+                    out << ", Дней назначения: " << worker.getDaysAssigned() << "\n";
+                }
+            }
+            else if (choice == 3) {
+                if (workers.size() <= 1) {
+                    out << "Нельзя уволить работников. Директор должен остаться.\n";
+                    continue;
+                }
+                out << "\nВыберите работника для увольнения:\n";
+                for (size_t i = 0; i < workers.size(); ++i) {
+                    auto [worker, role] = workers.at(i);
+                    out << i + 1 << ". Имя: " << worker.getName() << ", Должность: " << role.title << "\n";
+                }
+                int fireChoice = co_await readNumber(io, choicePrompt("Выберите работника", workers.size()), 0, workers.size());
+                if (fireChoice >= 1 && fireChoice <= static_cast<int>(workers.size())) {
+                    WorkerRoster::Entry fired = workers.at(fireChoice - 1);
+                    if (fired.role.type == WorkerType::DIRECTOR) {
+                        out << "Нельзя уволить директора.\n";
+                    }
+                    else {
+                        pmr::string firedName(fired.worker.getName(), &dayArena);
+                        workers.erase(fireChoice - 1);
+                        touch();
+                        out << firedName << " уволен.\n";
+                    }
+                }
+            }
+            else if (choice == 4) {
+                if (workers.empty()) {
+                    out << "В зоопарке нет работников.\n";
+                    continue;
+                }
+                if (enclosures.empty()) {
+                    out << "В зоопарке нет вольеров.\n";
+                    continue;
+                }
+                out << "\nВыберите работника для назначения:\n";
+                for (size_t i = 0; i < workers.size(); ++i) {
+                    auto [worker, role] = workers.at(i);
+                    out << i + 1 << ". Имя: " << worker.getName() << ", Должность: " << role.title << "\n";
+                }
+                int workerChoice = co_await readNumber(io, choicePrompt("Выберите работника", workers.size()), 0, workers.size());
+                if (workerChoice == 0) continue;
+                if (workerChoice < 1 || workerChoice > static_cast<int>(workers.size())) {
+                    out << "Неверный выбор работника.\n";
+                    continue;
+                }
+                auto [selectedWorker, role] = workers.at(workerChoice - 1);
+                if (role.maxEnclosures == 0) {
+                    out << "Директор не может быть назначен на вольеры.\n";
+                    continue;
+                }
+                out << "\nВыберите вольер для назначения:\n";
+                for (const auto& enc : enclosures) {
+                    out << "ID " << enc.getId() << " (" << enc.getAnimalCount() << "/" << enc.getCapacity() << " животных)\n";
+                }
+                int encId = co_await readNumber(io, "Введите ID вольера (0 для отмены): ", 0, enclosures.back().getId());
+                if (encId == 0) continue;
+                bool validEnclosure = false;
+                for (const auto& enc : enclosures) {
+                    if (enc.getId() == encId) {
+                        validEnclosure = true;
+                        break;
+                    }
                 }
-                else {
-                    if (position == WorkerType::CLEANER) {
-                        cout << "Назначьте 1 вольер для уборщика:\n";
-                        for (const auto& enc : enclosures) {
-                            cout << "ID " << enc.getId() << " (" << enc.getAnimalCount() << "/" << enc.getCapacity() << " животных)\n";
-                        }
-                        int encId = getValidInput("Введите ID вольера: ", 1, enclosures.back().getId());
-                        bool valid = false;
+                if (!validEnclosure) {
+                    out << "Неверный ID вольера.\n";
+                    continue;
+                }if (find(selectedWorker.getAssignedEnclosures().begin(), selectedWorker.getAssignedEnclosures().end(), encId) != selectedWorker.getAssignedEnclosures().end()) {
+                    out << "Работник уже назначен на этот вольер.\n";
+                    continue;
+                }
+                if (selectedWorker.getAssignedEnclosures().size() >= role.maxEnclosures) {
+                    out << "Этот работник уже назначен на максимальное количество вольеров.\n";
+                    continue;
+                }
+                if (role.maxAnimals > 0) {
+                    size_t totalAnimals = 0;
+                    for (const auto& encIdAssigned : selectedWorker.getAssignedEnclosures()) {
                         for (const auto& enc : enclosures) {
-                            if (enc.getId() == encId) {
-                                newWorker.assignEnclosure(encId);
-                                valid = true;
+                            if (enc.getId() == encIdAssigned) {
+                                totalAnimals += enc.getAnimalCount();
                                 break;
                             }
                         }
-                        if (!valid) cout << "Неверный ID вольера. Назначение отменено.\n";
                     }
-                    else if (position == WorkerType::FEEDER) {
-                        cout << "Назначьте до 2 вольеров для кормильца (введите ID или 0 для завершения):\n";
-                        for (int i = 0; i < 2; ++i) {
-                            for (const auto& enc : enclosures) {
-                                cout << "ID " << enc.getId() << " (" << enc.getAnimalCount() << "/" << enc.getCapacity() << " животных)\n";
-                            }
-                            int encId = getValidInput("Введите ID вольера (0 для завершения): ", 0, enclosures.back().getId());
-                            if (encId == 0) break;
-                            bool valid = false;
-                            for (const auto& enc : enclosures) {
-                                if (enc.getId() == encId) {
-                                    newWorker.assignEnclosure(encId);
-                                    valid = true;
-                                    break;
-                                }
-                            }
-                            if (!valid) cout << "Неверный ID вольера.\n";
-                        }
+                    const Enclosure* target = findEnclosure(encId);
+                    if (totalAnimals + target->getAnimalCount() > static_cast<size_t>(role.maxAnimals)) {
+                        out << "Назначение этого вольера приведет к превышению лимита в " << role.maxAnimals << " животных.\n";
+                        continue;
                     }
-                    else if (position == WorkerType::VETERINARIAN) {
-                        int totalAnimalsAssigned = 0;
-                        cout << "Назначайте вольеры для ветеринара (до 20 животных). Введите ID или 0 для завершения:\n";
-                        while (true) {
-                            for (const auto& enc : enclosures) {
-                                cout << "ID " << enc.getId() << " (" << enc.getAnimalCount() << "/" << enc.getCapacity() << " животных)\n";
-                            }
-                            int encId = getValidInput("Введите ID вольера (0 для завершения): ", 0, enclosures.back().getId());
-                            if (encId == 0) break;
-                            bool valid = false;
-                            for (const auto& enc : enclosures) {
-                                if (enc.getId() == encId) {
-                                    int animalCount = enc.getAnimalCount();
-                                    if (totalAnimalsAssigned + animalCount > 20) {
-                                        cout << "Превышен лимит в 20 животных.\n";
-                                    }
-                                    else {
-                                        newWorker.assignEnclosure(encId);
-                                        totalAnimalsAssigned += animalCount;
-                                        cout << "Вольер " << encId << " назначен. Всего животных: " << totalAnimalsAssigned << "\n";
-                                    }
-                                    valid = true;
-                                    break;
-                                }
-                            }
-                            if (!valid) cout << "Неверный ID вольера.\n";
-                        }
+                }
+                int daysAssigned = co_await readNumber(io, "Введите количество дней назначения: ", 1, 365);
+                selectedWorker.assignEnclosure(encId);
+                selectedWorker.setDaysAssigned(daysAssigned);
+                touch();
+                out << selectedWorker.getName() << " назначен на вольер " << encId << " на " << daysAssigned << " дней.\n";
+            }
+            else if (choice == 5) break;
+        }
+    }
+
+    /**
+     * @brief Управляет операциями по покупкам (еда, реклама, кредиты).
+     * @param io Канал сессии.
+     */
+    Task<> managePurchases(Console& io) {
+        ostream& out = io.output();
+        while (true) {
+            DayArena::Scope scope(dayArena);
+            const char* prompt = "\nУправление покупками:\n"
+                "1. Купить еду\n"
+                "2. Потратить на рекламу\n"
+                "3. Взять кредит\n"
+                "4. Просмотреть кредиты\n"
+                "5. Назад\n"
+                "Выберите действие: ";
+            int choice = co_await readNumber(io, prompt, 1, 5);
+
+            if (choice == 1) {
+                pmr::string foodPrompt(&dayArena);
+                foodPrompt.append("Введите количество еды для покупки ($").append(to_string(rules.foodPrice)).append(" за единицу): ");
+                int foodAmount = co_await readNumber(io, foodPrompt, 0, 10000);
+                if (buyFood(foodAmount)) out << foodAmount << " единиц еды куплено.\n";
+                else out << "Недостаточно денег!\n";
+            }
+            else if (choice == 2) {
+                int adSpend = co_await readNumber(io, "Введите сумму для рекламы ($200 = +5 популярности): ", 0, 10000);
+                if (money >= adSpend) {
+                    popularity += (adSpend / 200) * 5;
+                    money -= adSpend;
+                    touch();
+                    out << "Популярность увеличена на " << (adSpend / 200) * 5 << ".\n";
+                }
+                else out << "Недостаточно денег!\n";
+            }
+            else if (choice == 3) {
+                int amount = co_await readNumber(io, "Введите сумму кредита: ", 1, 1000000);
+                int days = co_await readNumber(io, "Введите количество дней для погашения (1-20): ", 1, 20);
+                loans.emplace_back(static_cast<double>(amount), days, rules.loanDailyRate);
+                money += amount;
+                touch();
+                out << "Кредит на $" << amount << " взят на " << days << " дней с дневной процентной ставкой " << rules.loanDailyRate * 100 << "%.\n";
+            }
+            else if (choice == 4) {
+                if (loans.empty()) out << "\nУ вас нет активных кредитов.\n";else {
+                    out << "\nТекущие кредиты:\n";
+                    for (size_t i = 0; i < loans.size(); ++i) {
+                        const auto& loan = loans[i];
+                        out << i + 1 << ". Сумма: $" << loan.principal
+                            << ", Дневная процентная ставка: " << (loan.dailyInterestRate * 100) << "%"
+                            << ", Осталось дней: " << loan.daysLeft << ", Ежедневный платеж: $" << loan.dailyRepayment
+                            << ", Остаток долга: $" << loan.getRemainingDebt() << "\n";
                     }
                 }
-                workers.push_back(newWorker);
+            }
+            else if (choice == 5) break;
+        }
+    }
+
+    /**
+     * @brief Управляет операциями с вольерами (строительство и просмотр).
+     * @param io Канал сессии.
+     */
+    Task<> manageEnclosures(Console& io) {
+        ostream& out = io.output();
+        while (true) {
+            DayArena::Scope scope(dayArena);
+            const char* prompt = "\nУправление вольерами:\n"
+                "1. Построить новый вольер\n"
+                "2. Просмотреть вольеры\n"
+                "3. Назад\n"
+                "Выберите действие: ";
+            int choice = co_await readNumber(io, prompt, 1, 3);
+            if (choice == 1) {
+                int capacity = co_await readNumber(io, "Введите вместимость (макс. животных): ", 1, 100);
+                int typeChoice = co_await readNumber(io, "Выберите тип животных (1: Травоядные, 2: Хищники): ", 1, 2);
+                AnimalType animalType = (typeChoice == 1) ? AnimalType::HERBIVORE : AnimalType::CARNIVORE;
+                int climateChoice = co_await readNumber(io, "Выберите климат (1: Тропический, 2: Умеренный, 3: Арктический): ", 1, 3);
+                Climate climate;
+                switch (climateChoice) {
+                case 1: climate = Climate::TROPICAL; break;
+                case 2: climate = Climate::TEMPERATE; break;
+                case 3: climate = Climate::ARCTIC; break;
+                default: climate = Climate::TEMPERATE;
+                }
+                int cost = capacity * rules.enclosureSlotCost;
+                if (money >= cost) {
+                    int newId = enclosures.empty() ? 1 : enclosures.back().getId() + 1;
+                    enclosures.emplace_back(newId, capacity, animalType, climate, capacity * rules.enclosureSlotUpkeep);
+                    money -= cost;
+                    touch();
+                    out << "Вольер " << newId << " построен за $" << cost << ".\n";
+                }
+                else out << "Недостаточно денег!\n";
             }
             else if (choice == 2) {
-                if (workers.empty()) {
-                    cout << "В зоопарке нет работников.\n";
+                if (enclosures.empty()) {
+                    out << "В зоопарке нет вольеров.\n";
                     continue;
                 }
-                cout << "\nИнформация о работниках:\n";
-                for (size_t i = 0; i < workers.size(); ++i) {
-                    const auto& worker = workers[i];
-                    cout << i + 1 << ". Имя: " << worker.getName()
-                        << ", Должность: " << worker.getTypeString()
-                        << ", Зарплата: $" << worker.getSalary()
-                        << ", Дней проработано: " << worker.getDaysWorked();
-                    if (worker.getType() == WorkerType::VETERINARIAN) {
-                        cout << ", Управляемых животных: " << worker.getMaxAnimals();
+                out << "\nВольеры:\n";
+                for (const auto& enc : enclosures) {
+                    out << "ID: " << enc.getId()
+                        << ", Вместимость: " << enc.getCapacity()
+                        << ", Животных: " << enc.getAnimalCount()
+                        << ", Тип: " << (enc.getAnimalType() == AnimalType::HERBIVORE ? "Травоядные" : "Хищники")
+                        << ", Климат: ";
+                    switch (enc.getClimate()) {
+                    case Climate::TROPICAL: out << "Тропический"; break;
+                    case Climate::TEMPERATE: out << "Умеренный"; break;
+                    case Climate::ARCTIC: out << "Арктический"; break;
                     }
-                    cout << ", Вольеры: ";
-                    const auto& encIds = worker.getAssignedEnclosures();
-                    if (encIds.empty()) cout << "Нет";
-                    else {
-                        for (size_t j = 0; j < encIds.size(); ++j) {
-                            cout << encIds[j];
-                            if (j < encIds.size() - 1) cout << ", ";
+                    out << ", Ежедневная стоимость: $" << enc.getDailyCost() << "\n";
+                }
+            }
+            else if (choice == 3) break;
+        }
+    }
+
+    /**
+     * @brief Управляет операциями по размножению животных.
+     * @param io Канал сессии.
+     */
+    Task<> manageBreeding(Console& io) {
+        ostream& out = io.output();
+        while (true) {
+            DayArena::Scope scope(dayArena);
+            const char* prompt = "\nУправление размножением:\n"
+                "1. Размножить животных\n"
+                "2. Назад\n"
+                "Выберите действие: ";
+            int choice = co_await readNumber(io, prompt, 1, 2);
+            if (choice == 1) {
+                if (animals.size() < 2) {
+                    out << "Недостаточно животных для размножения.\n";
+                    continue;
+                }
+                if (none_of(enclosures.begin(), enclosures.end(), [](const Enclosure& e) { return e.hasBreedingPair(); })) {
+                    out << "Ни в одном вольере нет взрослых самца и самки.\n";
+                    continue;
+                }
+                out << "\nВыберите двух животных для размножения.\n";
+                uint32_t firstId = co_await pickAnimal(io, "Первое животное");
+                if (firstId == 0) continue;
+                uint32_t secondId = co_await pickAnimal(io, "Второе животное");
+                if (secondId == 0) continue;
+                if (firstId == secondId) {
+                    out << "Нельзя выбрать одно и то же животное.\n";
+                    continue;
+                }
+                const Animal& first = *findAnimal(firstId);
+                const Animal& second = *findAnimal(secondId);
+                if (first.getEnclosureId() != second.getEnclosureId()) {
+                    out << "Животные должны быть в одном вольере для размножения.\n";
+                    continue;
+                }
+                const Enclosure* home = findEnclosure(first.getEnclosureId());
+                if (!home || !home->canAddAnimal(first)) {
+                    out << "Нет свободного места в вольере для новорожденного.\n";
+                    continue;
+                }
+                if (pedigree.isAncestor(firstId, secondId) || pedigree.isAncestor(secondId, firstId)) {
+                    out << "Внимание: одно из животных — предок другого, потомок будет инбредным.\n";
+                }
+                Animal mother = first, father = second;
+                try {
+                    pedigree.getKinship(mother.getUniqueId(), father.getUniqueId()); // рост кэша родства до проверки запаса
+                }
+                catch (const bad_alloc&) {
+                    pedigree.clearKinshipCache();
+                    cappedEvents++;
+                    out << "Бюджет памяти исчерпан: новое животное не может появиться.\n";
+                    continue;
+                }
+                if (!reserveIndividual(mother.getUniqueId(), father.getUniqueId())) continue;
+                try {
+                    Animal newborn = mother.breed(father, species, randomGender());
+                    newborn.setUniqueId(nextAnimalId++);
+                    float inbreeding = pedigree.addBirth(newborn.getUniqueId(), newborn.getSpeciesId(),
+                        mother.getUniqueId(), father.getUniqueId());
+                    pmr::string newbornName(speciesName(newborn), &dayArena);
+                    setDisplayName(newborn, newbornName.append("_Новорождённый"));
+                    for (auto& enc : enclosures) {
+                        if (enc.getId() == newborn.getEnclosureId()) {
+                            enc.addAnimal(newborn);
+                            break;
+                        }
+                    }
+                    appendAnimal(newborn);
+                    totalAnimals++;
+                    touch();
+                    out << "Новое животное родилось: " << speciesName(newborn) << " (" << displayName(newborn) << ")"
+                        << ", коэффициент инбридинга: " << inbreeding << ".\n";
+                }
+                catch (const runtime_error& e) {
+                    out << e.what() << "\n";
+                }
+                catch (const bad_alloc&) {
+                    cappedEvents++;
+                    out << "Бюджет памяти исчерпан: новое животное не может появиться.\n";
+                }
+            }
+            else break;
+        }
+    }
+
+    /**
+     * @brief Переходит к следующему дню, обновляя все операции зоопарка.
+     *
+     * Обновляет возраст животных, здоровье, пожертвования, количество посетителей и финансовые транзакции.
+     * Обрабатывает случайные события, такие как болезни и смерть. Рынок и броски старения и болезни
+     * берутся из фонового расчета (DayForecast), если он готов, иначе вычисляются на месте с тем же результатом.
+     */
+    void nextDay() {
+        auto phaseStart = telemetry ? chrono::steady_clock::now() : chrono::steady_clock::time_point();
+        dayArena.reset();
+        day++;
+        animalsBoughtToday = 0;
+        journalValid = false;
+        versions.clear();
+        touch();
+        bool precomputed = forecast.finish(day);
+        if (!ownMarket) marketAnimals.clear();
+        else if (precomputed) fillMarket(forecast.getMarketOrder(), forecast.getMarketGenders());
+        else {
+            pmr::vector<uint32_t> order(&dayArena);
+            pmr::vector<Gender> genders(&dayArena);
+            Rng marketRng(Rng::keyed(seed, day, 0, DayForecast::marketStream));
+            DayForecast::planMarket(marketRng, catalog.size(), order, genders);
+            fillMarket(order, genders);
+        }
+
+        specialVisitorType = "None";
+        specialVisitorCount = 0;
+
+        // Столбцы данных животных для пакетной обработки. Новые болезни до конца дня ни на что не влияют,
+        // поэтому отмечаются в том же проходе, что и смерти от старости. Кандидаты на смерть от старости
+        // берутся из индекса периодов рождения, без просмотра молодых животных.
+        size_t count = animals.size();
+        pmr::vector<uint32_t> ids(&dayArena);
+        pmr::vector<int32_t> ages(&dayArena);
+        pmr::vector<uint8_t> sick(&dayArena), agingRolls(count, &dayArena), sicknessRolls(count, &dayArena);
+        pmr::vector<uint8_t> dies((count + 7) / 8, &dayArena), fallsSick((count + 7) / 8, &dayArena);
+        ids.reserve(count);
+        ages.reserve(count);
+        sick.reserve(count);
+        for (const auto& animal : animals) {
+            ids.push_back(animal.getUniqueId());
+            ages.push_back(animal.getAgeDays());
+            sick.push_back(animal.getIsSick());
+        }
+        pmr::vector<uint32_t> elders(&dayArena);
+        syncPositions();
+        forEachOlderThan(rules.oldAgeDays, [&](int32_t, const pmr::vector<uint32_t>& group) {
+            for (uint32_t id : group) elders.push_back(positionById[id]);
+            return true;
+        });
+        dayRolls(ids, elders, precomputed && rollSeed == seed, agingRolls.data(), sicknessRolls.data());
+        AnimalKernels::markDay(ages.data(), agingRolls.data(), sick.data(), sicknessRolls.data(), count, rules.oldAgeDays,
+            rules.sicknessPercent, dies.data(), fallsSick.data());
+        size_t index = 0;
+        SlotCursor cursor = slotCursor();
+        for (auto it = animals.begin(); it != animals.end(); ++index) {
+            it->incrementDaysSincePurchase();
+            it->incrementAgeDays();
+            Enclosure* enc = cursor.enclosure(*it);
+            if (AnimalKernels::test(dies.data(), index)) {
+                *log << displayName(*it) << " умерло от старости.\n";
+                emit(TelemetryKind::DEATH_OLD_AGE, it->getUniqueId(), 1);
+                if (enc) enc->removeSlot(cursor.peek(*it));
+                forgetAnimal(*it);
+                it = eraseAnimal(it);
+                totalAnimals--;
+            }
+            else {
+                if (AnimalKernels::test(fallsSick.data(), index)) it->setSick(true);
+                if (enc) {
+                    size_t slot = cursor.take(*it);
+                    enc->setFlag(slot, Enclosure::SICK, it->getIsSick());
+                    enc->setFlag(slot, Enclosure::BREEDING_ELIGIBLE, it->canBreed());
+                }
+                ++it;
+            }
+        }
+        for (auto& c : cohorts.getCohorts()) {
+            int age = day - c.birthDay;
+            if (age <= rules.oldAgeDays) continue;
+            uint64_t dead = cullCohort(c, min(age, 100) / 100.0);
+            if (dead > 0) emit(TelemetryKind::DEATH_OLD_AGE, c.speciesId, static_cast<double>(dead));
+            if (dead > 0) *log << "Стадо " << species.getName(c.speciesId) << " (вольер " << c.enclosureId
+                << "): " << dead << " умерло от старости.\n";
+        }
+        phaseDone(0, phaseStart);
+        workers.forEachCrew([](auto& crew) {
+            for (auto& worker : crew.members) {
+                worker.incrementDaysWorked();
+                worker.decrementDaysAssigned();
+                if (worker.getDaysAssigned() == 0) worker.clearAssignedEnclosures();
+            }
+        });
+        for (auto& c : cohorts.getCohorts()) c.sick += binomial(c.count - c.sick, rules.sicknessPercent / 100.0);
+
+        uint32_t crewStart = 0;
+        workers.forEachCrew([&](auto& crew) {
+            using Role = typename decay_t<decltype(crew)>::RoleType;
+            if constexpr (Role::effect == DailyEffect::TREAT_SICK) {
+                for (size_t w = 0; w < crew.members.size(); ++w) {
+                    if (crew.members[w].getDaysAssigned() == 0) continue;
+                    int treated = treat<Role>(crew.members[w]);
+                    if (treated > 0) emit(TelemetryKind::TREATMENT, crewStart + static_cast<uint32_t>(w), treated);
+                }
+            }
+            crewStart += static_cast<uint32_t>(crew.members.size());
+        });
+        phaseDone(1, phaseStart);
+
+        long long foodNeeded = dailyFoodDemand();
+        if (food >= foodNeeded) food -= static_cast<int>(foodNeeded);
+        else {
+            pmr::vector<uint8_t> starves((animals.size() + 7) / 8, &dayArena);
+            batchRng.fillBernoulli(rules.starvationPercent / 100.0, starves.data(), animals.size());
+            size_t index = 0;
+            SlotCursor starvingCursor = slotCursor();
+            for (auto it = animals.begin(); it != animals.end(); ++index) {
+                Enclosure* enc = starvingCursor.enclosure(*it);
+                if (AnimalKernels::test(starves.data(), index)) {
+                    if (enc) enc->removeSlot(starvingCursor.peek(*it));
+                    *log << displayName(*it) << " умерло от голода.\n";
+                    emit(TelemetryKind::DEATH_HUNGER, it->getUniqueId(), 1);
+                    forgetAnimal(*it);
+                    it = eraseAnimal(it);
+                    totalAnimals--;
+                }
+                else {
+                    if (enc) starvingCursor.take(*it);
+                    ++it;
+                }
+            }
+            for (auto& c : cohorts.getCohorts()) {
+                uint64_t dead = cullCohort(c, rules.starvationPercent / 100.0);
+                if (dead > 0) emit(TelemetryKind::DEATH_HUNGER, c.speciesId, static_cast<double>(dead));
+                if (dead > 0) *log << "Стадо " << species.getName(c.speciesId) << " (вольер " << c.enclosureId
+                    << "): " << dead << " умерло от голода.\n";
+            }
+        }
+        cohorts.removeEmpty();
+        phaseDone(2, phaseStart);
+
+        popularity *= (1.0 + (random(-10, 10) / 100.0));
+        long long sickCount = 0;
+        for (const auto& enc : enclosures) sickCount += static_cast<long long>(enc.countFlag(Enclosure::SICK));
+        for (const auto& c : cohorts.getCohorts()) sickCount += static_cast<long long>(c.sick);
+        popularity -= sickCount;
+        if (popularity < 0) popularity = 0;
+
+        visitors = static_cast<int>(popularity);
+        int specialRoll = random(0, 99);
+        if (specialRoll < 20) {
+            specialVisitorType = "None";
+            specialVisitorCount = 0;
+        }
+        else if (specialRoll < 30) {
+            specialVisitorType = "Celebrity";
+            specialVisitorCount = random(1, 2);
+            popularity += specialVisitorCount * 10;
+        }
+        else if (specialRoll < 50) {
+            specialVisitorType = "Photographer";
+            specialVisitorCount = random(1, 3);
+            popularity += specialVisitorCount * 5;
+        }
+
+        double income = static_cast<double>(visitors) * totalAnimals;
+        money += income;
+        emit(TelemetryKind::INCOME, 0, income);
+
+        money -= workers.payroll();
+        for (const auto& enc : enclosures) money -= enc.getDailyCost();
+        for (auto& loan : loans) {
+            if (loan.daysLeft > 0) {
+                money -= loan.dailyRepayment;
+                loan.daysLeft--;
+                if (loan.daysLeft == 0) *log << "Кредит на $" << loan.principal << " погашен.\n";
+            }
+        }
+        loans.erase(remove_if(loans.begin(), loans.end(), [](const Loan& loan) { return loan.daysLeft <= 0; }), loans.end());
+        phaseDone(3, phaseStart);
+        startForecast();
+    }
+
+    /**
+     * @brief Ведет игру через канал сессии на срок Rules::maxDays дней.
+     *
+     * Сообщения о событиях дня на время игры направляются в тот же канал. Если источник ввода
+     * закрывается, игра заканчивается.
+     * @param io Канал сессии.
+     */
+    Task<> play(Console& io) {
+        ostream& out = io.output();
+        ostream* previousLog = log;
+        log = &out;
+        const int maxDays = rules.maxDays;
+        startForecast();
+        try {
+            while (day <= maxDays) {
+                DayArena::Scope scope(dayArena);
+                displayStatus(out);
+                const char* prompt = "\nДействия:\n"
+                    "1. Управление животными\n"
+                    "2. Управление покупками\n"
+                    "3. Управление вольерами\n"
+                    "4. Управление работниками\n"
+                    "5. Управление размножением\n"
+                    "6. Следующий день\n"
+                    "7. Подробный отчет\n"
+                    "8. Пакетная команда\n"
+                    "9. Отменить действие\n"
+                    "10. Повторить отмененное\n"
+                    "Выберите действие: ";
+                checkpoint();
+                int choice = co_await readNumber(io, prompt, 1, 10);
+
+                try {
+                    if (choice == 1) co_await manageAnimals(io);
+                    else if (choice == 2) co_await managePurchases(io);
+                    else if (choice == 3) co_await manageEnclosures(io);
+                    else if (choice == 4) co_await manageWorkers(io);
+                    else if (choice == 5) co_await manageBreeding(io);
+                    else if (choice == 6) {
+                        nextDay();
+                        if (money < 0) {
+                            out << "\nИгра окончена! У вас закончились деньги на день " << day << ".\n";
+                            break;
+                        }
+                    }
+                    else if (choice == 7) displayReport(out);
+                    else if (choice == 8) {
+                        out << "Команды: купить 20 Кролик в 3; продать все болен=да; назначить ветеринаров по кругу 30.\n"
+                            "Введите команду: ";
+                        string command = co_await io.readLine();
+                        try {
+                            out << runCommand(command).message << "\n";
+                        }
+                        catch (const runtime_error& e) {
+                            out << e.what() << "\n";
                         }
                     }
-                    cout << ", Дней назначения: " << worker.getDaysAssigned() << "\n";
+                    else if (choice == 9) out << (undo() ? "Действие отменено.\n" : "Нечего отменять.\n");
+                    else if (choice == 10) out << (redo() ? "Действие повторено.\n" : "Нечего повторять.\n");
                 }
-            }
-            else if (choice == 3) {
-                if (workers.size() <= 1) {
-                    cout << "Нельзя уволить работников. Директор должен остаться.\n";
-                    continue;
+                catch (const bad_alloc&) {
+                    cappedEvents++;
+                    out << "Бюджет памяти исчерпан: действие прервано.\n";
                 }
-                cout << "\nВыберите работника для увольнения:\n";
-                for (size_t i = 0; i < workers.size(); ++i) {
-                    const auto& worker = workers[i];
-                    cout << i + 1 << ". Имя: " << worker.getName() << ", Должность: " << worker.getTypeString() << "\n";
-                }
-                int fireChoice = getValidInput("Выберите работника (1-" + to_string(workers.size()) + ") или 0 для отмены: ", 0, workers.size());
-                if (fireChoice >= 1 && fireChoice <= static_cast<int>(workers.size())) {
-                    if (workers[fireChoice - 1].getType() == WorkerType::DIRECTOR) {
-                        cout << "Нельзя уволить директора.\n";
-                    }
-                    else {
-                        string firedName = workers[fireChoice - 1].getName();
-                        workers.erase(workers.begin() + (fireChoice - 1));
-                        cout << firedName << " уволен.\n";
+            }
+            if (day > maxDays) {
+                out << "\nПоздравляем! Вы успешно управляли зоопарком \"" << name << "\" в течение " << maxDays << " дней!\n";
+            }
+        }
+        catch (const Console::Closed&) {
+        }
+        log = previousLog;
+    }
+
+    /**
+     * @brief Запускает игру в консоли: строки стандартного ввода передаются сопрограмме игры.
+     */
+    void playGame() {
+        Console io(cout);
+        Task<> game = play(io);
+        game.start();
+        string line;
+        while (!game.done() && getline(cin, line)) io.feed(std::move(line));
+        if (!game.done()) io.close();
+        game.get();
+    }
+};
+
+/** @brief Зоопарк со стандартными правилами. */
+using Zoo = BasicZoo<StandardRules>;
+
+/**
+ * @struct RunResult
+ * @brief Итог одного пакетного прогона зоопарка.
+ */
+struct RunResult {
+    uint64_t seed;             /**< Зерно зоопарка */
+    int days;                  /**< Прожито дней */
+    double money;              /**< Деньги в конце прогона */
+    long long animals;         /**< Животных в конце прогона */
+    double popularity;         /**< Популярность в конце прогона */
+    bool bankrupt;             /**< Прогон закончился банкротством */
+};
+
+/**
+ * @class MonteCarlo
+ * @brief Пакетные прогоны зоопарка без участия игрока.
+ *
+ * Каждый прогон — отдельный зоопарк с автопилотом (см. Zoo::autopilotDay), выполняемый задачей пула.
+ * Зерно прогона берется из генератора, привязанного к номеру задачи, поэтому набор результатов
+ * одинаков при любом числе потоков.
+ */
+class MonteCarlo {
+private:
+    static constexpr uint64_t shiftStream = 9;        /**< Поток зерен прогонов со сдвигом бросков */
+    static constexpr uint64_t independentStream = 10; /**< Поток зерен второго варианта без общих чисел */
+
+public:
+    /**
+     * @struct VarianceReduction
+     * @brief Способы уменьшения дисперсии при сравнении двух вариантов правил.
+     */
+    struct VarianceReduction {
+        bool commonNumbers = true;   /**< Оба варианта проходят на одних зернах и бросках */
+        bool antithetic = false;     /**< К каждому прогону добавляется зеркальный */
+        uint32_t rollShifts = 1;     /**< Прогонов со сдвигом бросков и общим зерном бросков в одном испытании */
+    };
+
+    /**
+     * @struct Comparison
+     * @brief Оценка разницы доли выживших зоопарков (без банкротства) между двумя вариантами.
+     */
+    struct Comparison {
+        size_t trials = 0;           /**< Испытаний (независимых групп прогонов) */
+        size_t games = 0;            /**< Прогонов каждого варианта */
+        double survivalA = 0;        /**< Доля выживших в варианте A */
+        double survivalB = 0;        /**< Доля выживших в варианте B */
+        double difference = 0;       /**< Оценка survivalA - survivalB */
+        double halfWidth = 0;        /**< Полуширина 95% доверительного интервала разницы */
+        double independentHalfWidth = 0; /**< Полуширина при том же числе независимых прогонов */
+    };
+
+    /**
+     * @brief Выполняет один прогон.
+     * @param seed Зерно зоопарка.
+     * @param days Количество дней.
+     * @param telemetry Писатель телеметрии (nullptr — без телеметрии).
+     * @param source Номер прогона в событиях телеметрии.
+     * @param rules Правила игры.
+     * @param upstream Источник памяти зоопарка.
+     * @param sampling Выборка бросков (по умолчанию обычный прогон).
+     * @return Итог прогона.
+     */
+    template<class Rules = StandardRules>
+    static RunResult runOne(uint64_t seed, int days, TelemetryWriter* telemetry = nullptr, uint32_t source = 0,
+        const Rules& rules = Rules(), pmr::memory_resource* upstream = pmr::get_default_resource(),
+        const RollSampling& sampling = RollSampling()) {
+        ostream quiet(nullptr);
+        BasicZoo<Rules> zoo("Монте-Карло", upstream, seed, rules);
+        zoo.setLog(quiet);
+        zoo.setTelemetry(telemetry, source);
+        zoo.setBackgroundForecast(false);
+        zoo.setSampling(sampling);
+        RunResult result{ seed, 0, 0.0, 0, 0.0, false };
+        while (result.days < days) {
+            zoo.autopilotDay();
+            zoo.nextDay();
+            result.days++;
+            if (zoo.getMoney() < 0) {
+                result.bankrupt = true;
+                break;
+            }
+        }
+        result.money = zoo.getMoney();
+        result.animals = zoo.getTotalAnimals();
+        result.popularity = zoo.getPopularity();
+        return result;
+    }
+
+    /**
+     * @brief Выполняет серию прогонов в пуле потоков.
+     * @param runs Количество прогонов.
+     * @param days Количество дней в каждом прогоне.
+     * @param seed Зерно серии.
+     * @param telemetry Писатель телеметрии (nullptr — без телеметрии); источник события — номер прогона.
+     * @param pool Пул исполнения.
+     * @param rules Правила игры.
+     * @return Итоги прогонов в порядке номеров.
+     */
+    template<class Rules = StandardRules>
+    static vector<RunResult> run(size_t runs, int days, uint64_t seed, TelemetryWriter* telemetry = nullptr,
+        TaskPool& pool = TaskPool::shared(), const Rules& rules = Rules()) {
+        vector<RunResult> results(runs);
+        TaskGroup group(pool, seed);
+        for (size_t i = 0; i < runs; ++i) {
+            group.run([&results, &rules, i, days, telemetry](Rng& rng) {
+                results[i] = runOne(rng(), days, telemetry, static_cast<uint32_t>(i), rules);
+            });
+        }
+        group.wait();
+        return results;
+    }
+
+    /**
+     * @brief Выводит сводку серии прогонов.
+     * @param results Итоги прогонов.
+     * @param out Поток вывода.
+     */
+    static void report(const vector<RunResult>& results, ostream& out) {
+        if (results.empty()) return;
+        double n = static_cast<double>(results.size());
+        double meanMoney = 0, meanAnimals = 0, meanPopularity = 0, meanDays = 0;
+        size_t bankrupt = 0;
+        for (const auto& r : results) {
+            meanMoney += r.money / n;
+            meanAnimals += r.animals / n;
+            meanPopularity += r.popularity / n;
+            meanDays += r.days / n;
+            if (r.bankrupt) bankrupt++;
+        }
+        double variance = 0;
+        for (const auto& r : results) variance += (r.money - meanMoney) * (r.money - meanMoney);
+        double stddev = results.size() > 1 ? sqrt(variance / (n - 1)) : 0.0;
+        out << "Прогонов: " << results.size() << "\n";
+        out << "Банкротств: " << bankrupt << " (" << 100.0 * bankrupt / n << "%)\n";
+        out << "Прожито дней: в среднем " << meanDays << "\n";
+        out << "Деньги в конце: в среднем $" << meanMoney << ", стандартное отклонение $" << stddev << "\n";
+        out << "Животных в конце: в среднем " << meanAnimals << "\n";
+        out << "Популярность в конце: в среднем " << meanPopularity << "\n";
+    }
+
+    /**
+     * @brief Оценивает разницу доли выживших между двумя вариантами правил.
+     *
+     * Испытание — группа прогонов с одним зерном: rollShifts прогонов со сдвигом бросков (у каждого свое
+     * зерно зоопарка, но общее зерно бросков, см. RollSampling), при антитетической выборке каждый еще и
+     * в зеркальном варианте; с общими числами
+     * вариант B проходит ровно те же прогоны, что и A. Итог испытания — разница средних долей, поэтому
+     * интервал строится по разбросу испытаний и учитывает все корреляции внутри них. Испытания
+     * запускаются пакетами, пока полуширина интервала не станет не больше цели или не кончится лимит.
+     * Без сдвигов и зеркал прогоны варианта A совпадают с прогонами run с тем же зерном.
+     * @param a Правила варианта A.
+     * @param b Правила варианта B.
+     * @param reduction Способы уменьшения дисперсии.
+     * @param maxTrials Наибольшее число испытаний.
+     * @param targetHalfWidth Цель для полуширины интервала (0 — выполнить все испытания).
+     * @param days Дней в прогоне.
+     * @param seed Зерно серии.
+     * @param pool Пул исполнения.
+     * @return Оценка.
+     */
+    static Comparison compare(const RuntimeRules& a, const RuntimeRules& b, const VarianceReduction& reduction, size_t maxTrials,
+        double targetHalfWidth, int days, uint64_t seed, TaskPool& pool = TaskPool::shared()) {
+        const uint32_t shifts = max<uint32_t>(reduction.rollShifts, 1);
+        const uint32_t mirrors = reduction.antithetic ? 2 : 1;
+        const double perTrial = static_cast<double>(shifts) * mirrors;
+        vector<pair<double, double>> survival(maxTrials);
+        Comparison result;
+        TaskGroup group(pool, seed);
+        while (result.trials < maxTrials) {
+            size_t end = min(maxTrials, max<size_t>(result.trials * 2, 16));
+            for (size_t t = result.trials; t < end; ++t) {
+                group.run([&survival, &a, &b, &reduction, shifts, mirrors, perTrial, days, t](Rng& rng) {
+                    uint64_t trialSeed = rng();
+                    pmr::unsynchronized_pool_resource memory;
+                    double survived[2] = { 0, 0 };
+                    for (int variant = 0; variant < 2; ++variant) {
+                        uint64_t base = variant == 1 && !reduction.commonNumbers ? Rng::keyed(trialSeed, 0, 0, independentStream) : trialSeed;
+                        for (uint32_t k = 0; k < shifts; ++k) {
+                            uint64_t zooSeed = k == 0 ? base : Rng::keyed(base, k, 0, shiftStream);
+                            for (uint32_t m = 0; m < mirrors; ++m) {
+                                RollSampling sampling{ base, m == 1, shifts, k };
+                                RunResult r = runOne(zooSeed, days, nullptr, 0, variant == 0 ? a : b, &memory, sampling);
+                                if (!r.bankrupt) survived[variant] += 1.0;
+                            }
+                        }
                     }
-                }
+                    survival[t] = { survived[0] / perTrial, survived[1] / perTrial };
+                });
             }
-            else if (choice == 4) {
-                if (workers.empty()) {
-                    cout << "В зоопарке нет работников.\n";
-                    continue;
-                }
-                if (enclosures.empty()) {
-                    cout << "В зоопарке нет вольеров.\n";
-                    continue;
-                }
-                cout << "\nВыберите работника для назначения:\n";
-                for (size_t i = 0; i < workers.size(); ++i) {
-                    const auto& worker = workers[i];
-                    cout << i + 1 << ". Имя: " << worker.getName() << ", Должность: " << worker.getTypeString() << "\n";
-                }
-                int workerChoice = getValidInput("Выберите работника (1-" + to_string(workers.size()) + ") или 0 для отмены: ", 0, workers.size());
-                if (workerChoice == 0) continue;
-                if (workerChoice < 1 || workerChoice > static_cast<int>(workers.size())) {
-                    cout << "Неверный выбор работника.\n";
-                    continue;
-                }
-                Worker& selectedWorker = workers[workerChoice - 1];
-                if (selectedWorker.getType() == WorkerType::DIRECTOR) {
-                    cout << "Директор не может быть назначен на вольеры.\n";
-                    continue;
+            group.wait();
+            result.trials = end;
+            double n = static_cast<double>(result.trials), sumA = 0, sumB = 0;
+            for (size_t t = 0; t < result.trials; ++t) {
+                sumA += survival[t].first;
+                sumB += survival[t].second;
+            }
+            result.survivalA = sumA / n;
+            result.survivalB = sumB / n;
+            result.difference = result.survivalA - result.survivalB;
+            double variance = 0;
+            for (size_t t = 0; t < result.trials; ++t) {
+                double d = survival[t].first - survival[t].second - result.difference;
+                variance += d * d;
+            }
+            result.halfWidth = result.trials > 1 ? 1.96 * sqrt(variance / (n - 1) / n) : 0.0;
+            result.games = result.trials * shifts * mirrors;
+            double games = static_cast<double>(result.games);
+            result.independentHalfWidth = 1.96 * sqrt((result.survivalA * (1 - result.survivalA) +
+                result.survivalB * (1 - result.survivalB)) / games);
+            if (targetHalfWidth > 0 && result.trials > 1 && result.halfWidth <= targetHalfWidth) break;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Выводит оценку разницы вариантов.
+     * @param c Оценка.
+     * @param out Поток вывода.
+     */
+    static void report(const Comparison& c, ostream& out) {
+        out << "Испытаний: " << c.trials << ", прогонов каждого варианта: " << c.games << "\n";
+        out << "Доля выживших: A " << c.survivalA << ", B " << c.survivalB << "\n";
+        out << "Разница A - B: " << c.difference << " ± " << c.halfWidth << " (95%)\n";
+        out << "Независимые прогоны дали бы ± " << c.independentHalfWidth;
+        if (c.halfWidth > 0) {
+            double ratio = c.independentHalfWidth / c.halfWidth;
+            out << ": для той же точности их понадобилось бы в " << ratio * ratio << " раза больше";
+        }
+        out << "\n";
+    }
+};
+
+/**
+ * @class ParameterSweep
+ * @brief Перебор параметров правил для балансировки.
+ *
+ * План — набор точек в пространстве параметров RuntimeRules: полная сетка по осям или латинский
+ * гиперкуб (каждая ось разбита на столько слоев, сколько точек, и каждый слой занят ровно одной точкой).
+ * Все точки прогоняются на одних и тех же зернах, поэтому разница между точками не смешивается с разницей
+ * между зернами. Задача пула — одно зерно во всех точках: правила точек собираются один раз до запуска,
+ * а зоопарки задачи берут память из ее пула, куда возвращаются блоки предыдущего зоопарка. Зерна задач
+ * совпадают с зернами MonteCarlo::run, поэтому точка с базовыми правилами повторяет обычную серию.
+ */
+class ParameterSweep {
+public:
+    static constexpr size_t maxSteps = 1000;      /**< Наибольшее число значений на оси */
+    static constexpr size_t maxPoints = 100000;   /**< Наибольшее число точек плана */
+
+    /**
+     * @struct Axis
+     * @brief Диапазон одного параметра.
+     */
+    struct Axis {
+        string field;          /**< Имя поля RuntimeRules */
+        double low;            /**< Нижняя граница */
+        double high;           /**< Верхняя граница */
+        size_t steps;          /**< Число значений в сетке */
+    };
+
+    /**
+     * @enum Design
+     * @brief Способ выбора точек.
+     */
+    enum class Design {
+        GRID,                  /**< Все сочетания значений осей */
+        LATIN_HYPERCUBE        /**< Латинский гиперкуб из заданного числа точек */
+    };
+
+    /**
+     * @struct Point
+     * @brief Точка плана.
+     */
+    struct Point {
+        vector<double> values; /**< Значения по осям (целочисленные поля — после округления) */
+        RuntimeRules rules;    /**< Правила точки */
+    };
+
+    /**
+     * @struct Row
+     * @brief Итог точки по всем зернам.
+     */
+    struct Row {
+        vector<double> values; /**< Значения по осям */
+        size_t runs;           /**< Прогонов */
+        size_t bankrupt;       /**< Банкротств */
+        double meanMoney;      /**< Средние деньги в конце */
+        double stddevMoney;    /**< Стандартное отклонение денег */
+        double meanAnimals;    /**< Среднее число животных */
+        double meanPopularity; /**< Средняя популярность */
+        double meanDays;       /**< Среднее число прожитых дней */
+    };
+
+    /**
+     * @brief Разбирает оси вида «поле=от:до[:шагов]» через запятую (например, sicknessPercent=5:25:5,foodPrice=1:3).
+     * @param text Описание осей.
+     * @return Оси; без числа шагов ось получает 5 значений. Значения целочисленных полей округляются.
+     * @throws runtime_error При ошибке формата, неизвестном поле, границе вне диапазона поля или числе шагов вне 1..maxSteps.
+     */
+    static vector<Axis> parseAxes(string_view text) {
+        vector<Axis> axes;
+        auto number = [](string_view token) {
+            double value = 0;
+            auto [end, ec] = from_chars(token.data(), token.data() + token.size(), value);
+            if (ec != errc() || end != token.data() + token.size()) throw runtime_error("Ожидалось число: " + string(token) + ".");
+            return value;
+        };
+        for (size_t pos = 0; pos <= text.size();) {
+            size_t end = min(text.find(',', pos), text.size());
+            string_view item = text.substr(pos, end - pos);
+            pos = end + 1;
+            size_t eq = item.find('=');
+            vector<string_view> parts;
+            for (size_t from = eq + 1; eq != string_view::npos && from <= item.size();) {
+                size_t to = min(item.find(':', from), item.size());
+                parts.push_back(item.substr(from, to - from));
+                from = to + 1;
+            }
+            if (parts.size() < 2 || parts.size() > 3) throw runtime_error("Ожидалось «поле=от:до[:шагов]»: " + string(item) + ".");
+            Axis axis{ string(item.substr(0, eq)), number(parts[0]), number(parts[1]), 5 };
+            RuntimeRules().set(axis.field, axis.low);
+            RuntimeRules().set(axis.field, axis.high);
+            if (parts.size() == 3) {
+                double steps = number(parts[2]);
+                if (steps != floor(steps)) throw runtime_error("Число шагов должно быть целым: " + string(parts[2]) + ".");
+                if (steps < 1 || steps > static_cast<double>(maxSteps)) {
+                    throw runtime_error("Число шагов должно быть от 1 до " + to_string(maxSteps) + ": " + string(parts[2]) + ".");
                 }
-                cout << "\nВыберите вольер для назначения:\n";
-                for (const auto& enc : enclosures) {
-                    cout << "ID " << enc.getId() << " (" << enc.getAnimalCount() << "/" << enc.getCapacity() << " животных)\n";
+                axis.steps = static_cast<size_t>(steps);
+            }
+            axes.push_back(std::move(axis));
+        }
+        return axes;
+    }
+
+    /**
+     * @brief Строит план.
+     * @param axes Оси.
+     * @param base Правила, от которых отсчитываются точки.
+     * @param design Способ выбора точек.
+     * @param points Число точек латинского гиперкуба (для сетки не используется).
+     * @param seed Зерно перестановок гиперкуба.
+     * @return Точки плана.
+     * @throws runtime_error Если точек больше maxPoints (или их нет в гиперкубе).
+     */
+    static vector<Point> plan(const vector<Axis>& axes, const RuntimeRules& base, Design design, size_t points, uint64_t seed) {
+        vector<Point> result;
+        if (design == Design::GRID) {
+            size_t total = 1;
+            for (const auto& axis : axes) {
+                if (axis.steps == 0 || total > maxPoints / axis.steps) {
+                    throw runtime_error("Сетка слишком велика: больше " + to_string(maxPoints) + " точек.");
                 }
-                int encId = getValidInput("Введите ID вольера (0 для отмены): ", 0, enclosures.back().getId());
-                if (encId == 0) continue;
-                bool validEnclosure = false;
-                for (const auto& enc : enclosures) {
-                    if (enc.getId() == encId) {
-                        validEnclosure = true;
-                        break;
-                    }
+                total *= axis.steps;
+            }
+            for (size_t k = 0; k < total; ++k) {
+                Point point{ {}, base };
+                for (size_t a = 0, rest = k; a < axes.size(); rest /= axes[a].steps, ++a) {
+                    const Axis& axis = axes[a];
+                    size_t step = rest % axis.steps;
+                    double t = axis.steps > 1 ? static_cast<double>(step) / static_cast<double>(axis.steps - 1) : 0.0;
+                    point.values.push_back(axis.low + (axis.high - axis.low) * t);
                 }
-                if (!validEnclosure) {
-                    cout << "Неверный ID вольера.\n";
-                    continue;
-                }if (find(selectedWorker.getAssignedEnclosures().begin(), selectedWorker.getAssignedEnclosures().end(), encId) != selectedWorker.getAssignedEnclosures().end()) {
-                    cout << "Работник уже назначен на этот вольер.\n";
-                    continue;
+                result.push_back(std::move(point));
+            }
+        }
+        else {
+            if (points == 0 || points > maxPoints) {
+                throw runtime_error("Число точек гиперкуба должно быть от 1 до " + to_string(maxPoints) + ".");
+            }
+            Rng rng(seed);
+            result.assign(points, Point{ {}, base });
+            vector<size_t> strata(points);
+            for (const auto& axis : axes) {
+                iota(strata.begin(), strata.end(), size_t(0));
+                for (size_t i = points; i > 1; --i) swap(strata[i - 1], strata[static_cast<size_t>(rng.uniform(0, static_cast<int>(i) - 1))]);
+                for (size_t i = 0; i < points; ++i) {
+                    double offset = static_cast<double>(rng() >> 11) * 0x1.0p-53;
+                    double t = (static_cast<double>(strata[i]) + offset) / static_cast<double>(points);
+                    result[i].values.push_back(axis.low + (axis.high - axis.low) * t);
                 }
-                int maxEnclosures = (selectedWorker.getType() == WorkerType::CLEANER) ? 1 : ((selectedWorker.getType() == WorkerType::FEEDER) ? 2 : numeric_limits<int>::max());
-                if (selectedWorker.getAssignedEnclosures().size() >= static_cast<size_t>(maxEnclosures)) {
-                    cout << "Этот работник уже назначен на максимальное количество вольеров.\n";
-                    continue;
+            }
+        }
+        for (auto& point : result) {
+            for (size_t a = 0; a < axes.size(); ++a) {
+                point.rules.set(axes[a].field, point.values[a]);
+                point.values[a] = point.rules.get(axes[a].field);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Прогоняет все точки плана на общих зернах.
+     * @param points Точки.
+     * @param seeds Прогонов на точку.
+     * @param days Дней в прогоне.
+     * @param seed Зерно серии (как у MonteCarlo::run).
+     * @param pool Пул исполнения.
+     * @return Итоги в порядке точек.
+     */
+    static vector<Row> run(const vector<Point>& points, size_t seeds, int days, uint64_t seed, TaskPool& pool = TaskPool::shared()) {
+        vector<vector<RunResult>> results(points.size(), vector<RunResult>(seeds));
+        TaskGroup group(pool, seed);
+        for (size_t j = 0; j < seeds; ++j) {
+            group.run([&results, &points, j, days](Rng& rng) {
+                uint64_t zooSeed = rng();
+                pmr::unsynchronized_pool_resource memory;
+                for (size_t p = 0; p < points.size(); ++p) {
+                    results[p][j] = MonteCarlo::runOne(zooSeed, days, nullptr, 0, points[p].rules, &memory);
                 }
-                if (selectedWorker.getType() == WorkerType::VETERINARIAN) {
-                    int totalAnimals = 0;
-                    for (const auto& encIdAssigned : selectedWorker.getAssignedEnclosures()) {
-                        for (const auto& enc : enclosures) {
-                            if (enc.getId() == encIdAssigned) {
-                                totalAnimals += enc.getAnimalCount();
-                                break;
-                            }
-                        }
-                    }
-                    for (const auto& enc : enclosures) {
-                        if (enc.getId() == encId) {
-                            if (totalAnimals + enc.getAnimalCount() > selectedWorker.getMaxAnimals()) {
-                                cout << "Назначение этого вольера приведет к превышению лимита в 20 животных.\n";
-                                continue;
-                            }
-                            break;
-                        }
-                    }
+            });
+        }
+        group.wait();
+        vector<Row> rows;
+        rows.reserve(points.size());
+        for (size_t p = 0; p < points.size(); ++p) {
+            Row row{ points[p].values, seeds, 0, 0, 0, 0, 0, 0 };
+            double n = static_cast<double>(seeds);
+            for (const auto& r : results[p]) {
+                row.meanMoney += r.money / n;
+                row.meanAnimals += r.animals / n;
+                row.meanPopularity += r.popularity / n;
+                row.meanDays += r.days / n;
+                if (r.bankrupt) row.bankrupt++;
+            }
+            double variance = 0;
+            for (const auto& r : results[p]) variance += (r.money - row.meanMoney) * (r.money - row.meanMoney);
+            row.stddevMoney = seeds > 1 ? sqrt(variance / (n - 1)) : 0.0;
+            rows.push_back(std::move(row));
+        }
+        return rows;
+    }
+
+    /**
+     * @brief Записывает таблицу итогов в CSV: столбцы осей, затем показатели точки.
+     * @param axes Оси.
+     * @param rows Итоги точек.
+     * @param out Поток вывода.
+     */
+    static void writeTable(const vector<Axis>& axes, const vector<Row>& rows, ostream& out) {
+        for (const auto& axis : axes) out << axis.field << ",";
+        out << "runs,survival,money_mean,money_sd,animals_mean,popularity_mean,days_mean\n";
+        for (const auto& row : rows) {
+            for (double value : row.values) out << value << ",";
+            out << row.runs << "," << 1.0 - static_cast<double>(row.bankrupt) / static_cast<double>(max<size_t>(row.runs, 1)) << ","
+                << row.meanMoney << "," << row.stddevMoney << "," << row.meanAnimals << "," << row.meanPopularity << ","
+                << row.meanDays << "\n";
+        }
+    }
+};
+
+/**
+ * @class World
+ * @brief Регион из многих зоопарков с общим рынком животных.
+ *
+ * Зоопарки не держат собственных рынков: животные выставляются на общий рынок мира, а заявки на покупку
+ * и продажу копятся в течение дня в очередях зоопарков и исполняются пакетом на границе дня. Пакет
+ * обрабатывается в фиксированном порядке: продажи по номерам зоопарков, затем покупки по лотам, причем
+ * из нескольких заявок на один лот побеждает заявка с наименьшим ключом, вычисленным из зерна, дня,
+ * лота и номера зоопарка. Поэтому итог не зависит ни от числа потоков, ни от порядка подачи заявок.
+ * Сам день (nextDay) зоопарки проживают параллельно, группами в пуле потоков.
+ */
+class World {
+public:
+    /**
+     * @struct Listing
+     * @brief Лот общего рынка.
+     */
+    struct Listing {
+        uint32_t id;           /**< Номер лота */
+        int expires;           /**< Последний день, в который лот выставлен */
+        Animal animal;         /**< Животное (вид — в справочнике мира) */
+    };
+
+private:
+    /**
+     * @struct Order
+     * @brief Заявка на покупку лота.
+     */
+    struct Order {
+        uint32_t listingId;    /**< Номер лота */
+        int32_t enclosureId;   /**< Вольер покупателя */
+    };
+
+    static constexpr uint64_t orderStream = 5;   /**< Поток ключей приоритета заявок */
+    static constexpr uint64_t listingStream = 6; /**< Поток состава новых лотов */
+    static constexpr size_t shardSize = 64;      /**< Зоопарков в одной задаче пула */
+    static constexpr int relistDays = 3;         /**< Сколько дней держится лот проданного зоопарком животного */
+
+    uint64_t seed;                         /**< Зерно мира */
+    int day;                               /**< Текущий день */
+    TaskPool& pool;                        /**< Пул исполнения */
+    ostream quiet;                         /**< Поток, подавляющий сообщения зоопарков */
+    SpeciesRegistry species;               /**< Справочник видов мира */
+    vector<Animal> catalog;                /**< Каталог видов для новых лотов */
+    vector<unique_ptr<Zoo>> zoos;          /**< Зоопарки */
+    vector<vector<Order>> buyOrders;       /**< Заявки на покупку по зоопаркам */
+    vector<vector<int>> sellOrders;        /**< Заявки на продажу (идентификаторы животных) по зоопаркам */
+    vector<Listing> listings;              /**< Лоты, упорядоченные по номеру */
+    uint32_t nextListingId;                /**< Следующий номер лота */
+    size_t listingTarget;                  /**< Сколько лотов держать на рынке */
+    long long trades;                      /**< Исполнено покупок */
+    long long contested;                   /**< Заявок, проигравших другим заявкам на тот же лот */
+
+    /**
+     * @brief Снимает просроченные лоты и пополняет рынок из каталога до целевого количества.
+     *
+     * Лоты из каталога живут один день, как рынок отдельного зоопарка; каталог перебирается
+     * перемешанными кругами, поэтому каждый вид представлен на рынке.
+     */
+    void restock() {
+        listings.erase(remove_if(listings.begin(), listings.end(), [this](const Listing& l) { return l.expires < day; }),
+            listings.end());
+        Rng r(Rng::keyed(seed, day, 0, listingStream));
+        pmr::vector<uint32_t> order;
+        pmr::vector<Gender> genders;
+        while (listings.size() < listingTarget) {
+            DayForecast::planMarket(r, catalog.size(), order, genders);
+            for (size_t i = 0; i < order.size() && listings.size() < listingTarget; ++i) {
+                const Animal& a = catalog[order[i]];
+                listings.push_back({ nextListingId++, day, Animal(a.getSpeciesId(), a.getAgeDays(), a.getWeight(),
+                    a.getPreferredClimate(), a.getPrice(), a.getType(), genders[i]) });
+            }
+        }
+    }
+
+    /**
+     * @brief Выставляет на рынок животное, проданное зоопарком.
+     * @param zoo Продавец.
+     * @param animal Проданное животное.
+     */
+    void relist(const Zoo& zoo, Animal animal) {
+        animal.setSpeciesId(species.intern(zoo.getSpeciesName(animal)));
+        animal.setEnclosureId(-1);
+        animal.setUniqueId(0);
+        listings.push_back({ nextListingId++, day + relistDays, animal });
+    }
+
+    /**
+     * @brief Исполняет накопленные заявки.
+     */
+    void settle() {
+        for (size_t z = 0; z < zoos.size(); ++z) {
+            for (int animalId : sellOrders[z]) {
+                if (auto animal = zoos[z]->sellAnimal(animalId)) relist(*zoos[z], *animal);
+            }
+            sellOrders[z].clear();
+        }
+
+        struct Bid {
+            uint32_t listingId;    /**< Номер лота */
+            uint64_t priority;     /**< Ключ приоритета (меньше — раньше) */
+            uint32_t zoo;          /**< Покупатель */
+            int32_t enclosureId;   /**< Вольер покупателя */
+        };
+        vector<Bid> bids;
+        for (size_t z = 0; z < zoos.size(); ++z) {
+            for (const Order& order : buyOrders[z]) {
+                bids.push_back({ order.listingId, Rng::keyed(seed, day, (static_cast<uint64_t>(order.listingId) << 32) | z, orderStream),
+                    static_cast<uint32_t>(z), order.enclosureId });
+            }
+            buyOrders[z].clear();
+        }
+        sort(bids.begin(), bids.end(), [](const Bid& a, const Bid& b) {
+            return a.listingId != b.listingId ? a.listingId < b.listingId : a.priority < b.priority;
+        });
+
+        vector<bool> taken(listings.size(), false);
+        for (const Bid& bid : bids) {
+            auto it = lower_bound(listings.begin(), listings.end(), bid.listingId,
+                [](const Listing& l, uint32_t id) { return l.id < id; });
+            if (it == listings.end() || it->id != bid.listingId) continue;
+            size_t index = it - listings.begin();
+            if (taken[index]) {
+                contested++;
+                continue;
+            }
+            if (zoos[bid.zoo]->receiveAnimal(it->animal, species.getName(it->animal.getSpeciesId()), bid.enclosureId)) {
+                taken[index] = true;
+                trades++;
+            }
+        }
+        size_t kept = 0;
+        for (size_t i = 0; i < listings.size(); ++i) {
+            if (!taken[i]) listings[kept++] = listings[i];
+        }
+        listings.erase(listings.begin() + kept, listings.end());
+    }
+
+public:
+    /**
+     * @brief Создает мир.
+     * @param zooCount Количество зоопарков.
+     * @param s Зерно мира (зерна зоопарков выводятся из него).
+     * @param p Пул исполнения.
+     */
+    World(size_t zooCount, uint64_t s, TaskPool& p = TaskPool::shared())
+        : seed(s), day(1), pool(p), quiet(nullptr), catalog(Zoo::getAvailableAnimals(species)), buyOrders(zooCount),
+        sellOrders(zooCount), nextListingId(1), listingTarget(catalog.size() + zooCount), trades(0), contested(0) {
+        zoos.reserve(zooCount);
+        for (size_t i = 0; i < zooCount; ++i) {
+            zoos.push_back(make_unique<Zoo>("Зоопарк " + to_string(i + 1), pmr::get_default_resource(), Rng::keyed(seed, 0, i, 0)));
+            zoos.back()->setOwnMarket(false);
+            zoos.back()->setBackgroundForecast(false);
+            zoos.back()->setLog(quiet);
+        }
+        restock();
+    }
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    /**
+     * @brief Получает количество зоопарков.
+     * @return Количество зоопарков.
+     */
+    size_t size() const { return zoos.size(); }
+
+    /**
+     * @brief Получает зоопарк.
+     * @param index Номер зоопарка.
+     * @return Ссылка на зоопарк.
+     */
+    Zoo& getZoo(size_t index) { return *zoos[index]; }
+
+    /**
+     * @brief Получает лоты общего рынка.
+     * @return Лоты, упорядоченные по номеру.
+     */
+    const vector<Listing>& getListings() const { return listings; }
+
+    /**
+     * @brief Получает название вида лота.
+     * @param listing Лот.
+     * @return Название вида.
+     */
+    string_view getSpeciesName(const Listing& listing) const { return species.getName(listing.animal.getSpeciesId()); }
+
+    /**
+     * @brief Подает заявку на покупку лота (исполняется в конце дня).
+     *
+     * Заявки разных зоопарков можно подавать из разных потоков одновременно.
+     * @param zoo Номер зоопарка.
+     * @param listingId Номер лота.
+     * @param enclosureId Вольер для животного.
+     */
+    void placeBuyOrder(size_t zoo, uint32_t listingId, int enclosureId) { buyOrders[zoo].push_back({ listingId, enclosureId }); }
+
+    /**
+     * @brief Подает заявку на продажу животного (исполняется в конце дня).
+     * @param zoo Номер зоопарка.
+     * @param animalId Идентификатор животного.
+     */
+    void placeSellOrder(size_t zoo, int animalId) { sellOrders[zoo].push_back(animalId); }
+
+    /**
+     * @brief Заканчивает день: исполняет заявки, проживает день во всех зоопарках и пополняет рынок.
+     */
+    void endDay() {
+        settle();
+        TaskGroup group(pool, seed);
+        for (size_t first = 0; first < zoos.size(); first += shardSize) {
+            group.run([this, first] {
+                for (size_t z = first; z < min(first + shardSize, zoos.size()); ++z) zoos[z]->nextDay();
+            });
+        }
+        group.wait();
+        day++;
+        restock();
+    }
+
+    /**
+     * @brief Подает заявки за зоопарк по простой стратегии.
+     *
+     * Зоопарк докупает еду, продает самое старое животное, если денег не хватает на день расходов,
+     * и иначе претендует на случайный доступный ему лот, для которого у него есть подходящий вольер
+     * (случайный выбор разводит заявки разных зоопарков по разным лотам).
+     * @param z Номер зоопарка.
+     */
+    void autopilot(size_t z) {
+        Zoo& zoo = *zoos[z];
+        zoo.autopilotDay();
+        double reserve = 3 * zoo.getDailyCosts();
+        if (zoo.getMoney() < zoo.getDailyCosts()) {
+            const auto& owned = zoo.getAnimals();
+            auto oldest = max_element(owned.begin(), owned.end(),
+                [](const Animal& a, const Animal& b) { return a.getAgeDays() < b.getAgeDays(); });
+            if (oldest != owned.end()) placeSellOrder(z, oldest->getUniqueId());
+            return;
+        }
+        vector<Order> candidates;
+        for (const Listing& listing : listings) {
+            if (zoo.getMoney() - listing.animal.getPrice() < reserve) continue;
+            for (const auto& enc : zoo.getEnclosures()) {
+                if (enc.canAddAnimal(listing.animal)) {
+                    candidates.push_back({ listing.id, enc.getId() });
+                    break;
                 }
-                int daysAssigned = getValidInput("Введите количество дней назначения: ", 1, 365);
-                selectedWorker.assignEnclosure(encId);
-                selectedWorker.setDaysAssigned(daysAssigned);
-                cout << selectedWorker.getName() << " назначен на вольер " << encId << " на " << daysAssigned << " дней.\n";
             }
-            else if (choice == 5) break;
         }
+        if (candidates.empty()) return;
+        const Order& pick = candidates[Rng::keyed(seed, day, z, orderStream) % candidates.size()];
+        placeBuyOrder(z, pick.listingId, pick.enclosureId);
+    }
+
+    /**
+     * @brief Проживает несколько дней, подавая заявки за все зоопарки параллельно.
+     * @param days Количество дней.
+     */
+    void run(int days) {
+        for (int d = 0; d < days; ++d) {
+            TaskGroup group(pool, seed);
+            for (size_t first = 0; first < zoos.size(); first += shardSize) {
+                group.run([this, first] {
+                    for (size_t z = first; z < min(first + shardSize, zoos.size()); ++z) autopilot(z);
+                });
+            }
+            group.wait();
+            endDay();
+        }
+    }
+
+    /**
+     * @brief Выводит сводку по миру.
+     * @param out Поток вывода.
+     */
+    void report(ostream& out) const {
+        size_t bankrupt = 0;
+        long long animalsTotal = 0;
+        double moneyTotal = 0;
+        for (const auto& zoo : zoos) {
+            if (zoo->getMoney() < 0) bankrupt++;
+            animalsTotal += zoo->getTotalAnimals();
+            moneyTotal += zoo->getMoney();
+        }
+        out << "Зоопарков: " << zoos.size() << ", день " << day << "\n";
+        out << "Банкротов: " << bankrupt << "\n";
+        out << "Животных всего: " << animalsTotal << ", денег всего: $" << moneyTotal << "\n";
+        out << "Сделок на общем рынке: " << trades << ", проигравших заявок: " << contested
+            << ", лотов на рынке: " << listings.size() << "\n";
+    }
+};
+
+#ifdef __linux__
+/**
+ * @class GameServer
+ * @brief Сервер, обслуживающий много игровых сессий через сокет Unix в одном процессе.
+ *
+ * Одно соединение — одна сессия. Цикл событий построен на epoll и работает в одном потоке, поэтому
+ * все сессии (зоопарки, буферы ввода и вывода, таблица соединений) размещаются в общем пуле памяти
+ * без синхронизации. Зоопарки сессий живут без фонового расчета и без сообщений в консоль.
+ *
+ * Протокол строковый: запрос — одна строка, ответ — одна строка, начинающаяся с OK или ERR.
+ * - N <название> — начать новую игру;
+ * - S — состояние: день, деньги, еда, популярность, посетители, животные;
+ * - M — рынок: индекс:вид:цена:тип:климат через «;»;
+ * - E — вольеры: id:тип:климат:занято/вместимость через «;»;
+ * - A — животные: id:вид:возраст:болен через «;»;
+ * - B <индекс> <вольер> — купить животное с рынка;
+ * - X <id> — продать животное;
+ * - F <количество> — купить еду;
+ * - C <команда> — пакетная команда (Zoo::runCommand), ответ: выполнено единиц и изменение денег;
+ * - D — следующий день;
+ * - P — играть через обычные меню: дальнейшие строки передаются игре (Zoo::play), ее вывод
+ *   возвращается как есть, а по окончании игры приходит OK;
+ * - Q — закончить сессию.
+ *
+ * Игры в режиме P — сопрограммы, приостановленные на вводе, поэтому один поток ведет их все.
+ */
+class GameServer {
+private:
+    /**
+     * @struct Connection
+     * @brief Состояние одного соединения.
+     */
+    struct Connection {
+        pmr::string input;     /**< Непрочитанная часть запросов */
+        pmr::string output;    /**< Неотправленная часть ответов */
+        StringSink sink;       /**< Буфер потока, пишущий в output */
+        ostream stream;        /**< Поток вывода игры */
+        Console console;       /**< Канал игры в режиме P */
+        Task<> game;           /**< Игра в режиме P */
+        Zoo* zoo;              /**< Зоопарк сессии (в пуле сервера) или nullptr */
+        bool writing;          /**< Подписка на готовность к записи включена */
+        bool closing;          /**< Закрыть после отправки ответов */
+
+        explicit Connection(pmr::memory_resource* r)
+            : input(r), output(r), sink(output), stream(&sink), console(stream), zoo(nullptr), writing(false), closing(false) {}
+    };
+
+    static constexpr size_t maxRequest = 1024;     /**< Наибольшая длина строки запроса */
+    static constexpr uint64_t sessionStream = 7;   /**< Поток зерен сессий */
+
+    string path;                                   /**< Путь к сокету */
+    uint64_t seed;                                 /**< Зерно сервера */
+    int listenFd;                                  /**< Слушающий сокет */
+    int epollFd;                                   /**< Дескриптор epoll */
+    atomic<bool> stopping;                         /**< Запрос на остановку цикла */
+    uint64_t sessionsStarted;                      /**< Начато игр (для зерен сессий) */
+    ostream quiet;                                 /**< Поток, подавляющий сообщения зоопарков */
+    pmr::unsynchronized_pool_resource pool;        /**< Общий пул памяти сессий */
+    pmr::unordered_map<int, Connection> connections; /**< Соединения по дескриптору */
+
+    /**
+     * @brief Бросает исключение с описанием последней системной ошибки.
+     * @param what Неудавшееся действие.
+     */
+    [[noreturn]] static void fail(const string& what) {
+        throw runtime_error(what + ": " + strerror(errno));
     }
 
     /**
-     * @brief Управляет операциями по покупкам (еда, реклама, кредиты).
+     * @brief Подписывает дескриптор на события epoll или меняет подписку.
+     * @param fd Дескриптор.
+     * @param events Маска событий.
+     * @param op EPOLL_CTL_ADD или EPOLL_CTL_MOD.
      */
-    void managePurchases() {
-        while (true) {
-            string prompt = "\nУправление покупками:\n"
-                "1. Купить еду\n"
-                "2. Потратить на рекламу\n"
-                "3. Взять кредит\n"
-                "4. Просмотреть кредиты\n"
-                "5. Назад\n"
-                "Выберите действие: ";
-            int choice = getValidInput(prompt, 1, 5);
+    void watch(int fd, uint32_t events, int op) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd, op, fd, &ev) < 0) fail("epoll_ctl");
+    }
 
-            if (choice == 1) {
-                int foodAmount = getValidInput("Введите количество еды для покупки ($2 за единицу): ", 0, 10000);
-                if (money >= foodAmount * 2) {
-                    food += foodAmount;
-                    money -= foodAmount * 2;
-                    cout << foodAmount << " единиц еды куплено.\n";
-                }
-                else cout << "Недостаточно денег!\n";
-            }
-            else if (choice == 2) {
-                int adSpend = getValidInput("Введите сумму для рекламы ($200 = +5 популярности): ", 0, 10000);
-                if (money >= adSpend) {
-                    popularity += (adSpend / 200) * 5;
-                    money -= adSpend;
-                    cout << "Популярность увеличена на " << (adSpend / 200) * 5 << ".\n";
-                }
-                else cout << "Недостаточно денег!\n";
-            }
-            else if (choice == 3) {
-                int amount = getValidInput("Введите сумму кредита: ", 1, 1000000);
-                int days = getValidInput("Введите количество дней для погашения (1-20): ", 1, 20);
-                loans.emplace_back(static_cast<double>(amount), days);
-                money += amount;
-                cout << "Кредит на $" << amount << " взят на " << days << " дней с дневной процентной ставкой 0.5%.\n";
-            }
-            else if (choice == 4) {
-                if (loans.empty()) cout << "\nУ вас нет активных кредитов.\n";else {
-                    cout << "\nТекущие кредиты:\n";
-                    for (size_t i = 0; i < loans.size(); ++i) {
-                        const auto& loan = loans[i];
-                        cout << i + 1 << ". Сумма: $" << loan.principal
-                            << ", Дневная процентная ставка: " << (loan.dailyInterestRate * 100) << "%"
-                            << ", Осталось дней: " << loan.daysLeft << ", Ежедневный платеж: $" << loan.dailyRepayment
-                            << ", Остаток долга: $" << loan.getRemainingDebt() << "\n";
-                    }
-                }
-            }
-            else if (choice == 5) break;
+    /**
+     * @brief Уничтожает зоопарк сессии и возвращает его память в пул.
+     * @param c Соединение.
+     */
+    void endSession(Connection& c) {
+        c.game = Task<>();
+        c.console.detach();
+        if (!c.zoo) return;
+        c.zoo->~Zoo();
+        pmr::polymorphic_allocator<Zoo>(&pool).deallocate(c.zoo, 1);
+        c.zoo = nullptr;
+    }
+
+    /**
+     * @brief Начинает новую игру в соединении.
+     * @param c Соединение.
+     * @param name Название зоопарка.
+     */
+    void startSession(Connection& c, string_view name) {
+        endSession(c);
+        pmr::polymorphic_allocator<Zoo> alloc(&pool);
+        Zoo* zoo = alloc.allocate(1);
+        try {
+            new (zoo) Zoo(string(name), &pool, Rng::keyed(seed, sessionsStarted++, 0, sessionStream));
+        }
+        catch (...) {
+            alloc.deallocate(zoo, 1);
+            throw;
         }
+        zoo->setLog(quiet);
+        zoo->setBackgroundForecast(false);
+        c.zoo = zoo;
     }
 
     /**
-     * @brief Управляет операциями с вольерами (строительство и просмотр).
+     * @brief Закрывает соединение.
+     * @param fd Дескриптор соединения.
      */
-    void manageEnclosures() {
-        while (true) {
-            string prompt = "\nУправление вольерами:\n"
-                "1. Построить новый вольер\n"
-                "2. Просмотреть вольеры\n"
-                "3. Назад\n"
-                "Выберите действие: ";
-            int choice = getValidInput(prompt, 1, 3);
-            if (choice == 1) {
-                int capacity = getValidInput("Введите вместимость (макс. животных): ", 1, 100);
-                int typeChoice = getValidInput("Выберите тип животных (1: Травоядные, 2: Хищники): ", 1, 2);
-                AnimalType animalType = (typeChoice == 1) ? AnimalType::HERBIVORE : AnimalType::CARNIVORE;
-                int climateChoice = getValidInput("Выберите климат (1: Тропический, 2: Умеренный, 3: Арктический): ", 1, 3);
-                Climate climate;
-                switch (climateChoice) {
-                case 1: climate = Climate::TROPICAL; break;
-                case 2: climate = Climate::TEMPERATE; break;
-                case 3: climate = Climate::ARCTIC; break;
-                default: climate = Climate::TEMPERATE;
-                }
-                int cost = capacity * 50;
-                if (money >= cost) {
-                    int newId = enclosures.empty() ? 1 : enclosures.back().getId() + 1;
-                    enclosures.emplace_back(newId, capacity, animalType, climate, capacity * 2);
-                    money -= cost;
-                    cout << "Вольер " << newId << " построен за $" << cost << ".\n";
-                }
-                else cout << "Недостаточно денег!\n";
-            }
-            else if (choice == 2) {
-                if (enclosures.empty()) {
-                    cout << "В зоопарке нет вольеров.\n";
-                    continue;
-                }
-                cout << "\nВольеры:\n";
-                for (const auto& enc : enclosures) {
-                    cout << "ID: " << enc.getId()
-                        << ", Вместимость: " << enc.getCapacity()
-                        << ", Животных: " << enc.getAnimalCount()
-                        << ", Тип: " << (enc.getAnimalType() == AnimalType::HERBIVORE ? "Травоядные" : "Хищники")
-                        << ", Климат: ";
-                    switch (enc.getClimate()) {
-                    case Climate::TROPICAL: cout << "Тропический"; break;
-                    case Climate::TEMPERATE: cout << "Умеренный"; break;
-                    case Climate::ARCTIC: cout << "Арктический"; break;
-                    }
-                    cout << ", Ежедневная стоимость: $" << enc.getDailyCost() << "\n";
-                }
-            }
-            else if (choice == 3) break;
+    void drop(int fd) {
+        auto it = connections.find(fd);
+        if (it != connections.end()) {
+            endSession(it->second);
+            connections.erase(it);
         }
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
     }
 
     /**
-     * @brief Управляет операциями по размножению животных.
+     * @brief Принимает все ожидающие соединения.
      */
-    void manageBreeding() {
+    void acceptAll() {
         while (true) {
-            string prompt = "\nУправление размножением:\n"
-                "1. Размножить животных\n"
-                "2. Назад\n"
-                "Выберите действие: ";
-            int choice = getValidInput(prompt, 1, 2);
-            if (choice == 1) {
-                if (animals.size() < 2) {
-                    cout << "Недостаточно животных для размножения.\n";
-                    continue;
-                }
-                cout << "\nВыберите двух животных для размножения:\n";for (size_t i = 0; i < animals.size(); ++i) {
-                    cout << i + 1 << ". " << animals[i].getSpecies() << " (" << animals[i].getDisplayName()
-                        << "), Пол: " << (animals[i].getGender() == Gender::MALE ? "М" : "Ж")
-                        << ", ID вольера: " << animals[i].getEnclosureId() << "\n";
-                }
-                int first = getValidInput("Выберите первое животное (1-" + to_string(animals.size()) + ") или 0 для отмены: ", 0, animals.size());
-                if (first == 0) continue;
-                int second = getValidInput("Выберите второе животное (1-" + to_string(animals.size()) + ") или 0 для отмены: ", 0, animals.size());
-                if (second == 0) continue;
-                if (first == second) {
-                    cout << "Нельзя выбрать одно и то же животное.\n";
-                    continue;
-                }
-                first--; second--;
-                if (animals[first].getEnclosureId() != animals[second].getEnclosureId()) {
-                    cout << "Животные должны быть в одном вольере для размножения.\n";
-                    continue;
-                }
-                bool canAdd = false;
-                for (auto& enc : enclosures) {
-                    if (enc.getId() == animals[first].getEnclosureId() && enc.canAddAnimal(animals[first])) {
-                        canAdd = true;
-                        break;
-                    }
-                }
-                if (!canAdd) {
-                    cout << "Нет свободного места в вольере для новорожденного.\n";
-                    continue;
-                }
-                try {
-                    Animal newborn = animals[first] + animals[second];
-                    for (auto& enc : enclosures) {
-                        if (enc.getId() == newborn.getEnclosureId()) {
-                            enc.addAnimal(newborn);
-                            break;
-                        }
-                    }
-                    animals.push_back(newborn);
-                    totalAnimals++;
-                    cout << "Новое животное родилось: " << newborn.getSpecies() << " (" << newborn.getDisplayName() << ").\n";
-                }
-                catch (const runtime_error& e) {
-                    cout << e.what() << "\n";
-                }
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED || errno == EINTR) return;
+                if (errno == EMFILE || errno == ENFILE) return;
+                fail("accept4");
             }
-            else break;
+            connections.try_emplace(fd, &pool);
+            watch(fd, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_ADD);
         }
     }
 
     /**
-     * @brief Переходит к следующему дню, обновляя все операции зоопарка.
-     *
-     * Обновляет возраст животных, здоровье, пожертвования, количество посетителей и финансовые транзакции.
-     * Обрабатывает случайные события, такие как болезни и смерть.
+     * @brief Записывает число в кратчайшем виде, однозначно читаемом обратно.
+     * @param value Число.
+     * @return Текст числа.
      */
-    void nextDay() {
-        day++;
-        animalsBoughtToday = 0;
-        refreshMarket();
+    static string number(double value) {
+        char buffer[32];
+        auto [end, ec] = to_chars(buffer, buffer + sizeof(buffer), value);
+        return string(buffer, ec == errc() ? end : buffer);
+    }
 
-        specialVisitorType = "None";
-        specialVisitorCount = 0;
+    /**
+     * @brief Разбирает целое число в начале строки и отрезает его.
+     * @param args Остаток строки запроса.
+     * @param value Результат.
+     * @return Истина, если число прочитано.
+     */
+    template<typename T>
+    static bool takeNumber(string_view& args, T& value) {
+        size_t start = args.find_first_not_of(' ');
+        if (start == string_view::npos) return false;
+        args.remove_prefix(start);
+        auto [end, ec] = from_chars(args.data(), args.data() + args.size(), value);
+        if (ec != errc()) return false;
+        args.remove_prefix(end - args.data());
+        return true;
+    }
 
-        for (auto it = animals.begin(); it != animals.end();) {
-            it->incrementDaysSincePurchase();
-            it->incrementAgeDays();
-            if (it->getAgeDays() > 30 && random(0, 99) < it->getAgeDays()) {
-                cout << it->getDisplayName() << " умерло от старости.\n";
-                for (auto& enc : enclosures) {
-                    if (enc.getId() == it->getEnclosureId()) {
-                        enc.removeAnimal(it->getUniqueId());
-                        break;
-                    }
-                }
-                it = animals.erase(it);
-                totalAnimals--;
+    /**
+     * @brief Выполняет один запрос и дописывает ответ в буфер соединения.
+     * @param c Соединение.
+     * @param line Строка запроса без перевода строки.
+     */
+    void handle(Connection& c, string_view line) {
+        pmr::string& out = c.output;
+        if (!c.game.done()) {
+            c.console.feed(string(line));
+            if (c.game.done()) {
+                Task<> game = std::move(c.game);
+                game.get();
+                out += "OK\n";
             }
-            else ++it;
+            return;
+        }
+        if (line.empty()) {
+            out += "ERR empty\n";
+            return;
         }
-        for (auto& worker : workers) { // Исправлено: workers вместо work ers
-            worker.incrementDaysWorked();
-            worker.decrementDaysAssigned();
-            if (worker.getDaysAssigned() == 0) worker.clearAssignedEnclosures();
+        char command = line[0];
+        string_view args = line.substr(1);
+        if (command == 'Q') {
+            out += "OK\n";
+            c.closing = true;
+            return;
         }
-        for (auto& animal : animals) {
-            if (!animal.getIsSick() && random(0, 99) < 10) {
-                animal.setSick(true);
+        if (command == 'N') {
+            size_t start = args.find_first_not_of(' ');
+            if (start == string_view::npos) {
+                out += "ERR name\n";
+                return;
             }
+            startSession(c, args.substr(start));
+            out += "OK " + to_string(c.zoo->getDay()) + "\n";
+            return;
         }
-
-        for (auto& worker : workers) {
-            if (worker.getType() == WorkerType::VETERINARIAN && worker.getDaysAssigned() > 0) {
-                int treated = 0;for (auto& animal : animals) {
-                    if (animal.getIsSick() && treated < worker.getMaxAnimals()) {
-                        const auto& encIds = worker.getAssignedEnclosures();
-                        if (find(encIds.begin(), encIds.end(), animal.getEnclosureId()) != encIds.end()) {
-                            animal.setSick(false);
-                            treated++;
-                            for (auto& enc : enclosures) {
-                                if (enc.getId() == animal.getEnclosureId()) {
-                                    enc.updateAnimal(animal);
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                }
+        if (!c.zoo) {
+            out += "ERR no-game\n";
+            return;
+        }
+        Zoo& zoo = *c.zoo;
+        switch (command) {
+        case 'S':
+            out += "OK " + to_string(zoo.getDay()) + " " + number(zoo.getMoney()) + " " + to_string(zoo.getFood()) + " " +
+                number(zoo.getPopularity()) + " " + to_string(zoo.getVisitors()) + " " + to_string(zoo.getTotalAnimals()) + "\n";
+            return;
+        case 'M': {
+            out += "OK ";
+            const auto& market = zoo.getMarket();
+            for (size_t i = 0; i < market.size(); ++i) {
+                const Animal& a = market[i];
+                if (i > 0) out += ';';
+                out += to_string(i) + ":";
+                out += zoo.getSpeciesName(a);
+                out += ":" + to_string(a.getPrice()) + ":" + to_string(static_cast<int>(a.getType())) + ":" +
+                    to_string(static_cast<int>(a.getPreferredClimate()));
             }
+            out += '\n';
+            return;
         }
-
-        // Расчет количества необходимой еды
-        int foodNeeded = 0;
-        for (const auto& animal : animals) {
-            foodNeeded += (animal.getType() == AnimalType::HERBIVORE) ? 1 : 2;
+        case 'E': {
+            out += "OK ";
+            bool first = true;
+            for (const auto& enc : zoo.getEnclosures()) {
+                if (!first) out += ';';
+                first = false;
+                out += to_string(enc.getId()) + ":" + to_string(static_cast<int>(enc.getAnimalType())) + ":" +
+                    to_string(static_cast<int>(enc.getClimate())) + ":" + to_string(enc.getAnimalCount()) + "/" +
+                    to_string(enc.getCapacity());
+            }
+            out += '\n';
+            return;
         }
-        if (food >= foodNeeded) food -= foodNeeded;
-        else {
-            for (auto it = animals.begin(); it != animals.end();) {
-                if (random(0, 99) < 30) {
-                    for (auto& enc : enclosures) {
-                        if (enc.getId() == it->getEnclosureId()) {
-                            enc.removeAnimal(it->getUniqueId());
-                            break;
-                        }
-                    }
-                    cout << it->getDisplayName() << " умерло от голода.\n";
-                    it = animals.erase(it);
-                    totalAnimals--;
-                }
-                else ++it;
+        case 'A': {
+            out += "OK ";
+            bool first = true;
+            for (const auto& a : zoo.getAnimals()) {
+                if (!first) out += ';';
+                first = false;
+                out += to_string(a.getUniqueId()) + ":";
+                out += zoo.getSpeciesName(a);
+                out += ":" + to_string(a.getAgeDays()) + ":" + (a.getIsSick() ? "1" : "0");
+            }
+            out += '\n';
+            return;
+        }
+        case 'B': {
+            size_t index;
+            int encId;
+            if (!takeNumber(args, index) || !takeNumber(args, encId)) out += "ERR args\n";
+            else if (!zoo.buyAnimal(index, encId)) out += "ERR refused\n";
+            else out += "OK " + number(zoo.getMoney()) + "\n";
+            return;
+        }
+        case 'X': {
+            int id;
+            if (!takeNumber(args, id)) out += "ERR args\n";
+            else if (!zoo.sellAnimal(id)) out += "ERR refused\n";
+            else out += "OK " + number(zoo.getMoney()) + "\n";
+            return;
+        }
+        case 'C':
+            try {
+                BatchResult result = zoo.runCommand(args);
+                out += result.ok ? "OK " + to_string(result.applied) + " " + number(result.money) + "\n" : "ERR refused\n";
+            }
+            catch (const runtime_error&) {
+                out += "ERR args\n";
+            }
+            return;
+        case 'F': {
+            int amount;
+            if (!takeNumber(args, amount)) out += "ERR args\n";
+            else if (!zoo.buyFood(amount)) out += "ERR refused\n";
+            else out += "OK " + to_string(zoo.getFood()) + "\n";
+            return;
+        }
+        case 'P':
+            c.game = zoo.play(c.console);
+            c.game.start();
+            if (c.game.done()) {
+                Task<> game = std::move(c.game);
+                game.get();
+                out += "OK\n";
             }
+            return;
+        case 'D':
+            if (zoo.getMoney() < 0) {
+                out += "ERR bankrupt\n";
+                return;
+            }
+            zoo.nextDay();
+            out += "OK " + to_string(zoo.getDay()) + " " + number(zoo.getMoney()) + "\n";
+            return;
+        default:
+            out += "ERR command\n";
         }
+    }
 
-        popularity *= (1.0 + (random(-10, 10) / 100.0));
-        int sickCount = count_if(animals.begin(), animals.end(), [](const Animal& a) { return a.getIsSick(); });
-        popularity -= sickCount;
-        if (popularity < 0) popularity = 0;
+    /**
+     * @brief Отправляет накопленные ответы, сколько примет сокет.
+     * @param fd Дескриптор соединения.
+     * @param c Соединение.
+     * @return Ложь, если соединение закрыто.
+     */
+    bool flush(int fd, Connection& c) {
+        size_t sent = 0;
+        while (sent < c.output.size()) {
+            ssize_t n = ::send(fd, c.output.data() + sent, c.output.size() - sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                drop(fd);
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        c.output.erase(0, sent);
+        if (c.output.empty() && c.closing) {
+            drop(fd);
+            return false;
+        }
+        bool wantWrite = !c.output.empty();
+        if (wantWrite != c.writing) {
+            watch(fd, EPOLLIN | EPOLLRDHUP | (wantWrite ? EPOLLOUT : 0u), EPOLL_CTL_MOD);
+            c.writing = wantWrite;
+        }
+        return true;
+    }
 
-        visitors = static_cast<int>(popularity);
-        int specialRoll = random(0, 99);
-        if (specialRoll < 20) {
-            specialVisitorType = "None";
-            specialVisitorCount = 0;
+    /**
+     * @brief Читает и выполняет поступившие запросы соединения.
+     * @param fd Дескриптор соединения.
+     * @param c Соединение.
+     * @return Ложь, если соединение закрыто.
+     */
+    bool receive(int fd, Connection& c) {
+        char buffer[4096];
+        bool hangup = false;
+        while (true) {
+            ssize_t n = ::read(fd, buffer, sizeof(buffer));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                drop(fd);
+                return false;
+            }
+            if (n == 0) {
+                hangup = true;
+                break;
+            }
+            c.input.append(buffer, static_cast<size_t>(n));
         }
-        else if (specialRoll < 30) {
-            specialVisitorType = "Celebrity";
-            specialVisitorCount = random(1, 2);
-            popularity += specialVisitorCount * 10;
+        size_t consumed = 0;
+        while (!c.closing) {
+            size_t end = c.input.find('\n', consumed);
+            if (end == pmr::string::npos) break;
+            string_view line(c.input.data() + consumed, end - consumed);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            try {
+                handle(c, line);
+            }
+            catch (const bad_alloc&) {
+                c.output += "ERR memory\n";
+            }
+            consumed = end + 1;
         }
-        else if (specialRoll < 50) {
-            specialVisitorType = "Photographer";
-            specialVisitorCount = random(1, 3);
-            popularity += specialVisitorCount * 5;
+        c.input.erase(0, consumed);
+        if (hangup) {
+            // Клиент закончил запись: ответы на уже полученные строки отправляются до закрытия,
+            // а чтение больше не нужно.
+            c.closing = true;
+            watch(fd, EPOLLOUT, EPOLL_CTL_MOD);
+            c.writing = true;
+            return true;
+        }
+        if (c.input.size() > maxRequest) {
+            drop(fd);
+            return false;
         }
+        return true;
+    }
 
-        money += visitors * totalAnimals;
+public:
+    /**
+     * @brief Открывает сокет сервера.
+     * @param socketPath Путь к сокету Unix (существующий файл заменяется).
+     * @param s Зерно сервера (зерна сессий выводятся из него).
+     */
+    GameServer(const string& socketPath, uint64_t s)
+        : path(socketPath), seed(s), listenFd(-1), epollFd(-1), stopping(false), sessionsStarted(0), quiet(nullptr),
+        connections(&pool) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) throw runtime_error("Слишком длинный путь к сокету: " + path);
+        memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) fail("socket");
+        try {
+            ::unlink(path.c_str());
+            if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) fail("bind " + path);
+            if (listen(listenFd, SOMAXCONN) < 0) fail("listen");
+            epollFd = epoll_create1(EPOLL_CLOEXEC);
+            if (epollFd < 0) fail("epoll_create1");
+            watch(listenFd, EPOLLIN, EPOLL_CTL_ADD);
+        }
+        catch (...) {
+            if (epollFd >= 0) ::close(epollFd);
+            ::close(listenFd);
+            throw;
+        }
+    }
 
-        for (const auto& worker : workers) money -= worker.getSalary();
-        for (const auto& enc : enclosures) money -= enc.getDailyCost();
-        for (auto& loan : loans) {
-            if (loan.daysLeft > 0) {
-                money -= loan.dailyRepayment;
-                loan.daysLeft--;
-                if (loan.daysLeft == 0) cout << "Кредит на $" << loan.principal << " погашен.\n";
-            }
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    ~GameServer() {
+        for (auto& [fd, c] : connections) {
+            endSession(c);
+            ::close(fd);
         }
-        loans.erase(remove_if(loans.begin(), loans.end(), [](const Loan& loan) { return loan.daysLeft <= 0; }), loans.end());
+        connections.clear();
+        ::close(epollFd);
+        ::close(listenFd);
+        ::unlink(path.c_str());
     }
 
     /**
-     * @brief Запускает симуляцию зоопарка на срок до 20 дней.
+     * @brief Получает количество открытых соединений.
+     * @return Количество соединений.
      */
-    void playGame() {
-        const int maxDays = 20;
-        while (day <= maxDays) {
-            displayStatus();
-            string prompt = "\nДействия:\n"
-                "1. Управление животными\n"
-                "2. Управление покупками\n"
-                "3. Управление вольерами\n"
-                "4. Управление работниками\n"
-                "5. Управление размножением\n"
-                "6. Следующий день\n"
-                "Выберите действие: ";
-            int choice = getValidInput(prompt, 1, 6);
-
-            if (choice == 1) manageAnimals();
-            else if (choice == 2) managePurchases();
-            else if (choice == 3) manageEnclosures();
-            else if (choice == 4) manageWorkers();
-            else if (choice == 5) manageBreeding();
-            else if (choice == 6) {
-                nextDay();
-                if (money < 0) {
-                    cout << "\nИгра окончена! У вас закончились деньги на день " << day << ".\n";
-                    return;
+    size_t getConnectionCount() const { return connections.size(); }
+
+    /**
+     * @brief Обслуживает соединения до вызова stop().
+     */
+    void run() {
+        epoll_event events[64];
+        while (!stopping.load(memory_order_relaxed)) {
+            int n = epoll_wait(epollFd, events, 64, 200);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                fail("epoll_wait");
+            }
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptAll();
+                    continue;
                 }
+                auto it = connections.find(fd);
+                if (it == connections.end()) continue;
+                Connection& c = it->second;
+                if ((events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && !receive(fd, c)) continue;
+                flush(fd, c);
             }
         }
-        cout << "\nПоздравляем! Вы успешно управляли зоопарком \"" << name << "\" в течение " << maxDays << " дней!\n";
     }
+
+    /**
+     * @brief Просит цикл обслуживания завершиться (можно вызывать из другого потока).
+     */
+    void stop() { stopping.store(true, memory_order_relaxed); }
 };
 
+/** @brief Сервер, который останавливают сигналы SIGINT и SIGTERM. */
+static GameServer* runningServer = nullptr;
+
+/**
+ * @brief Обработчик сигналов остановки сервера.
+ */
+extern "C" void stopServer(int) {
+    if (runningServer) runningServer->stop();
+}
+#endif
+
+/**
+ * @brief Разбирает числовое значение параметра командной строки.
+ * @tparam T Тип числа.
+ * @param option Имя параметра (для сообщения об ошибке).
+ * @param text Значение параметра.
+ * @param value Результат (меняется, только если значение верно).
+ * @return Истина, если значение целиком записывает число типа T; иначе выводит ошибку.
+ */
+template<class T>
+static bool parseOption(string_view option, string_view text, T& value) {
+    T parsed{};
+    auto [end, ec] = from_chars(text.data(), text.data() + text.size(), parsed);
+    if (ec != errc() || end != text.data() + text.size() || text.empty()) {
+        cout << "Некорректное значение " << option << ": " << text << ".\n";
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
 /**
  * @brief Основная функция для запуска симуляции зоопарка.
- * @return 0 при успешном выполнении.
+ * @return 0 при успешном выполнении, 1 при ошибке в параметрах командной строки.
  */
-int main() {
+int main(int argc, char* argv[]) {
     setlocale(LC_ALL, "Russian_Russian.1251");
-    srand(time(0));
-    string name;
-    while (true) {
-        cout << "Введите название вашего зоопарка: ";
-        getline(cin, name);
-        if (!name.empty()) break;cout << "Название зоопарка не может быть пустым. Попробуйте снова.\n";
-    }
-    Zoo zoo(name);
-    zoo.playGame();
-    cin.get();
+    bool populationMode = false;
+    size_t monteCarloRuns = 0;
+    size_t worldZoos = 0;
+    string servePath;
+    string rulesName = "standard";
+    int monteCarloDays = 20;
+    uint64_t seed = static_cast<uint64_t>(time(0));
+    size_t memoryBudget = 0;
+    string telemetryPath;
+    string sweepAxes;
+    string sweepTable;
+    ParameterSweep::Design sweepDesign = ParameterSweep::Design::GRID;
+    size_t sweepPoints = 20;
+    string compareName;
+    string compareOverrides;
+    MonteCarlo::VarianceReduction reduction;
+    double targetHalfWidth = 0;
+    CapPolicy capPolicy = CapPolicy::REFUSE;
+    for (int i = 1; i < argc; ++i) {
+        string_view arg(argv[i]);
+        bool valid = true;
+        if (arg == "--population") populationMode = true;
+        else if (arg.substr(0, 16) == "--memory-budget=") {
+            size_t megabytes = 0;
+            valid = parseOption("--memory-budget", arg.substr(16), megabytes);
+            if (valid && megabytes > numeric_limits<size_t>::max() / (1024 * 1024)) {
+                cout << "Слишком большой бюджет памяти: " << megabytes << " МиБ.\n";
+                valid = false;
+            }
+            memoryBudget = megabytes * 1024 * 1024;
+        }
+        else if (arg == "--cap-policy=cohort") capPolicy = CapPolicy::COHORT;
+        else if (arg == "--cap-policy=refuse") capPolicy = CapPolicy::REFUSE;
+        else if (arg.substr(0, 14) == "--monte-carlo=") valid = parseOption("--monte-carlo", arg.substr(14), monteCarloRuns);
+        else if (arg.substr(0, 8) == "--world=") valid = parseOption("--world", arg.substr(8), worldZoos);
+        else if (arg.substr(0, 8) == "--serve=") servePath = string(arg.substr(8));
+        else if (arg.substr(0, 8) == "--rules=") rulesName = string(arg.substr(8));
+        else if (arg.substr(0, 7) == "--days=") valid = parseOption("--days", arg.substr(7), monteCarloDays);
+        else if (arg.substr(0, 7) == "--seed=") valid = parseOption("--seed", arg.substr(7), seed);
+        else if (arg.substr(0, 12) == "--telemetry=") telemetryPath = string(arg.substr(12));
+        else if (arg.substr(0, 8) == "--sweep=") sweepAxes = string(arg.substr(8));
+        else if (arg.substr(0, 14) == "--sweep-table=") sweepTable = string(arg.substr(14));
+        else if (arg == "--design=lhs") sweepDesign = ParameterSweep::Design::LATIN_HYPERCUBE;
+        else if (arg == "--design=grid") sweepDesign = ParameterSweep::Design::GRID;
+        else if (arg.substr(0, 9) == "--points=") valid = parseOption("--points", arg.substr(9), sweepPoints);
+        else if (arg.substr(0, 10) == "--compare=") compareName = string(arg.substr(10));
+        else if (arg.substr(0, 4) == "--b=") compareOverrides = string(arg.substr(4));
+        else if (arg == "--independent") reduction.commonNumbers = false;
+        else if (arg == "--antithetic") reduction.antithetic = true;
+        else if (arg.substr(0, 14) == "--roll-shifts=") valid = parseOption("--roll-shifts", arg.substr(14), reduction.rollShifts);
+        else if (arg.substr(0, 12) == "--target-ci=") valid = parseOption("--target-ci", arg.substr(12), targetHalfWidth);
+        if (!valid) return 1;
+    }
+    ofstream telemetryFile;
+    unique_ptr<TelemetryWriter> telemetry;
+    if (!telemetryPath.empty()) {
+        telemetryFile.open(telemetryPath);
+        if (telemetryFile) telemetry = make_unique<TelemetryWriter>(telemetryFile);
+        else cout << "Не удалось открыть файл телеметрии " << telemetryPath << ".\n";
+    }
+    if (worldZoos > 0) {
+        cout << "Мир: " << worldZoos << " зоопарков на " << monteCarloDays << " дней, зерно " << seed
+            << ", потоков: " << TaskPool::shared().size() << "\n";
+        World world(worldZoos, seed);
+        world.run(monteCarloDays);
+        world.report(cout);
+        return 0;
+    }
+    if (!servePath.empty()) {
+#ifdef __linux__
+        GameServer server(servePath, seed);
+        runningServer = &server;
+        signal(SIGINT, stopServer);
+        signal(SIGTERM, stopServer);
+        cout << "Сервер слушает " << servePath << endl;
+        server.run();
+        runningServer = nullptr;
+#else
+        cout << "Режим сервера доступен только в Linux.\n";
+#endif
+        return 0;
+    }
+    auto runVariant = [&](auto rules) {
+        using Rules = decltype(rules);
+        if (!sweepAxes.empty()) {
+            try {
+                auto axes = ParameterSweep::parseAxes(sweepAxes);
+                auto points = ParameterSweep::plan(axes, RuntimeRules::from<Rules>(), sweepDesign, sweepPoints, seed);
+                size_t runs = monteCarloRuns > 0 ? monteCarloRuns : 100;
+                cout << "Перебор параметров: " << points.size() << " точек по " << runs << " прогонов на " << monteCarloDays
+                    << " дней, зерно " << seed << ", правила " << rulesName << ", потоков: " << TaskPool::shared().size() << "\n";
+                auto rows = ParameterSweep::run(points, runs, monteCarloDays, seed);
+                ofstream tableFile;
+                if (!sweepTable.empty()) tableFile.open(sweepTable);
+                if (!sweepTable.empty() && !tableFile) cout << "Не удалось открыть файл таблицы " << sweepTable << ".\n";
+                ParameterSweep::writeTable(axes, rows, tableFile.is_open() ? tableFile : cout);
+            }
+            catch (const runtime_error& e) {
+                cout << e.what() << "\n";
+            }
+            return;
+        }
+        if (!compareName.empty() || !compareOverrides.empty()) {
+            optional<RuntimeRules> other;
+            if (compareName.empty()) {
+                compareName = rulesName;
+                other = RuntimeRules::from<Rules>();
+            }
+            else if (compareName == "standard") other = RuntimeRules::from<StandardRules>();
+            else if (compareName == "hardcore") other = RuntimeRules::from<HardcoreRules>();
+            else if (compareName == "sandbox") other = RuntimeRules::from<SandboxRules>();
+            if (!other) {
+                cout << "Неизвестный набор правил для сравнения " << compareName << ".\n";
+                return;
+            }
+            if (!compareOverrides.empty()) {
+                try {
+                    other->assign(compareOverrides);
+                }
+                catch (const runtime_error& e) {
+                    cout << e.what() << "\n";
+                    return;
+                }
+                compareName += " (" + compareOverrides + ")";
+            }
+            size_t trials = monteCarloRuns > 0 ? monteCarloRuns : 1000;
+            cout << "Сравнение: A — правила " << rulesName << ", B — правила " << compareName << ", до " << trials
+                << " испытаний по " << monteCarloDays << " дней, зерно " << seed << ", сдвигов бросков " << max<uint32_t>(reduction.rollShifts, 1)
+                << (reduction.antithetic ? ", зеркальные прогоны" : "") << (reduction.commonNumbers ? ", общие числа" : "")
+                << ", потоков: " << TaskPool::shared().size() << "\n";
+            MonteCarlo::report(MonteCarlo::compare(RuntimeRules::from<Rules>(), *other, reduction, trials, targetHalfWidth,
+                monteCarloDays, seed), cout);
+            return;
+        }
+        if (monteCarloRuns > 0) {
+            cout << "Монте-Карло: " << monteCarloRuns << " прогонов по " << monteCarloDays << " дней, зерно " << seed
+                << ", правила " << rulesName << ", потоков: " << TaskPool::shared().size() << "\n";
+            MonteCarlo::report(MonteCarlo::run<Rules>(monteCarloRuns, monteCarloDays, seed, telemetry.get()), cout);
+            if (telemetry) cout << "Потеряно событий телеметрии: " << telemetry->getDropped() << "\n";
+            return;
+        }
+        string name;
+        while (true) {
+            cout << "Введите название вашего зоопарка: ";
+            getline(cin, name);
+            if (!name.empty()) break;cout << "Название зоопарка не может быть пустым. Попробуйте снова.\n";
+        }
+        BasicZoo<Rules> zoo(name, pmr::get_default_resource(), seed);
+        zoo.setPopulationMode(populationMode);
+        zoo.setMemoryBudget(memoryBudget, capPolicy);
+        zoo.setTelemetry(telemetry.get());
+        zoo.playGame();
+        cin.get();
+    };
+    if (rulesName == "hardcore") runVariant(HardcoreRules{});
+    else if (rulesName == "sandbox") runVariant(SandboxRules{});
+    else {
+        if (rulesName != "standard") cout << "Неизвестный набор правил " << rulesName << ", используются стандартные.\n";
+        rulesName = "standard";
+        runVariant(StandardRules{});
+    }
     return 0;
 }
\ No newline at end of file